@@ -2,6 +2,8 @@
 #define _CAMERA_MODEL_H_
 
 #include <string>
+#include <cmath>
+#include <algorithm>
 #include <Eigen/Dense>
 
 using namespace Eigen;
@@ -31,6 +33,23 @@ public:
     virtual T GetFOV() const = 0;
     virtual Type GetType() const = 0;
 
+    T GetAngularResolution(const Matrix<T, 2, 1> &pixel) const
+    {
+        Matrix<T, 3, 1> bearing;
+        Matrix<T, 3, 1> bearingX;
+        Matrix<T, 3, 1> bearingY;
+        if (!UnprojectToBearing(pixel, bearing) || !UnprojectToBearing(pixel + Matrix<T, 2, 1>(T(1), T(0)), bearingX) || !UnprojectToBearing(pixel + Matrix<T, 2, 1>(T(0), T(1)), bearingY))
+        {
+            return T(0);
+        }
+        bearing.normalize();
+        bearingX.normalize();
+        bearingY.normalize();
+        T angleX = std::acos(std::min(T(1), bearing.dot(bearingX)));
+        T angleY = std::acos(std::min(T(1), bearing.dot(bearingY)));
+        return (angleX + angleY) / T(2);
+    }
+
 private:
     std::string name_;
 };
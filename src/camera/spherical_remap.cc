@@ -0,0 +1,111 @@
+#include "spherical_remap.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace omni_slam
+{
+namespace camera
+{
+
+SphericalRemap::SphericalRemap(const CameraModel<> &camera_model, const cv::Size &image_size, const Matrix3d &rotation, const double fov, const double resolution)
+    : cameraModel_(camera_model),
+    rotation_(rotation)
+{
+    double halfFov = (fov > 0 ? fov : camera_model.GetFOV()) / 2.;
+    // The poles sit on the rotated +-x axis and are only outside the image for lenses under 180 degrees,
+    // wider lenses lose a band around them rather than sampling the degenerate columns
+    const double poleMargin = 10. * M_PI / 180.;
+    double halfPolar = std::min(halfFov, M_PI / 2. - poleMargin);
+    double halfAzimuth = std::min(halfFov, M_PI);
+    resolution_ = resolution > 0 ? resolution : camera_model.GetAngularResolution(Vector2d(image_size.width / 2., image_size.height / 2.));
+    if (resolution_ <= 0)
+    {
+        resolution_ = 2. * halfFov / image_size.width;
+    }
+    minPolar_ = M_PI / 2. - halfPolar;
+    minAzimuth_ = -halfAzimuth;
+    size_ = cv::Size((int)std::ceil(2. * halfPolar / resolution_), (int)std::ceil(2. * halfAzimuth / resolution_));
+
+    cv::Mat mapX(size_, CV_32FC1);
+    cv::Mat mapY(size_, CV_32FC1);
+    #pragma omp parallel for
+    for (int r = 0; r < size_.height; r++)
+    {
+        float *rowX = mapX.ptr<float>(r);
+        float *rowY = mapY.ptr<float>(r);
+        for (int c = 0; c < size_.width; c++)
+        {
+            cv::Point2f pt;
+            if (RemapToImage(cv::Point2f(c, r), pt))
+            {
+                rowX[c] = pt.x;
+                rowY[c] = pt.y;
+            }
+            else
+            {
+                rowX[c] = -1;
+                rowY[c] = -1;
+            }
+        }
+    }
+    cv::convertMaps(mapX, mapY, map1_, map2_, CV_16SC2);
+}
+
+void SphericalRemap::Remap(const cv::Mat &image, cv::Mat &remapped) const
+{
+    cv::remap(image, remapped, map1_, map2_, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+}
+
+bool SphericalRemap::ImageToRemap(const cv::Point2f &pt, cv::Point2f &remap_pt) const
+{
+    Vector3d bearing;
+    if (!cameraModel_.UnprojectToBearing(Vector2d(pt.x, pt.y), bearing))
+    {
+        return false;
+    }
+    return BearingToRemap(bearing, remap_pt);
+}
+
+bool SphericalRemap::RemapToImage(const cv::Point2f &remap_pt, cv::Point2f &pt) const
+{
+    Vector3d bearing;
+    RemapToBearing(remap_pt, bearing);
+    Vector2d pixel;
+    if (!cameraModel_.ProjectToImage(bearing, pixel))
+    {
+        return false;
+    }
+    pt = cv::Point2f(pixel(0), pixel(1));
+    return true;
+}
+
+bool SphericalRemap::BearingToRemap(const Vector3d &bearing, cv::Point2f &remap_pt) const
+{
+    Vector3d rotBearing = rotation_ * bearing.normalized();
+    double polar = std::acos(std::min(1., std::max(-1., -rotBearing(0))));
+    double azimuth = std::atan2(rotBearing(1), rotBearing(2));
+    remap_pt = cv::Point2f((polar - minPolar_) / resolution_, (azimuth - minAzimuth_) / resolution_);
+    return remap_pt.x >= 0 && remap_pt.x < size_.width && remap_pt.y >= 0 && remap_pt.y < size_.height;
+}
+
+void SphericalRemap::RemapToBearing(const cv::Point2f &remap_pt, Vector3d &bearing) const
+{
+    double polar = minPolar_ + remap_pt.x * resolution_;
+    double azimuth = minAzimuth_ + remap_pt.y * resolution_;
+    Vector3d rotBearing(-std::cos(polar), std::sin(polar) * std::sin(azimuth), std::sin(polar) * std::cos(azimuth));
+    bearing = rotation_.transpose() * rotBearing;
+}
+
+const cv::Size& SphericalRemap::GetSize() const
+{
+    return size_;
+}
+
+double SphericalRemap::GetResolution() const
+{
+    return resolution_;
+}
+
+}
+}
@@ -0,0 +1,45 @@
+#ifndef _SPHERICAL_REMAP_H_
+#define _SPHERICAL_REMAP_H_
+
+#include "camera_model.h"
+#include <opencv2/opencv.hpp>
+#include <Eigen/Dense>
+
+using namespace Eigen;
+
+namespace omni_slam
+{
+namespace camera
+{
+
+// Equirectangular remap with its poles on the x axis of the rotated frame. Fields of view over 180 degrees
+// leave a band around the poles uncovered, callers must handle points for which ImageToRemap fails.
+class SphericalRemap
+{
+public:
+    SphericalRemap(const CameraModel<> &camera_model, const cv::Size &image_size, const Matrix3d &rotation = Matrix3d::Identity(), const double fov = 0., const double resolution = 0.);
+
+    void Remap(const cv::Mat &image, cv::Mat &remapped) const;
+    bool ImageToRemap(const cv::Point2f &pt, cv::Point2f &remap_pt) const;
+    bool RemapToImage(const cv::Point2f &remap_pt, cv::Point2f &pt) const;
+    bool BearingToRemap(const Vector3d &bearing, cv::Point2f &remap_pt) const;
+    void RemapToBearing(const cv::Point2f &remap_pt, Vector3d &bearing) const;
+
+    const cv::Size& GetSize() const;
+    double GetResolution() const;
+
+private:
+    const CameraModel<> &cameraModel_;
+    const Matrix3d rotation_;
+    double resolution_;
+    double minPolar_;
+    double minAzimuth_;
+    cv::Size size_;
+    cv::Mat map1_;
+    cv::Mat map2_;
+};
+
+}
+}
+
+#endif /* _SPHERICAL_REMAP_H_ */
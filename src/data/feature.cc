@@ -15,6 +15,14 @@ Feature::Feature(Frame &frame, cv::KeyPoint kpt, cv::Mat descriptor, bool stereo
 {
 }
 
+Feature::Feature(Frame &frame, cv::KeyPoint kpt, int descriptor_index, bool stereo)
+    : frame_(frame),
+    kpt_(kpt),
+    descriptorIndex_(descriptor_index),
+    stereo_(stereo)
+{
+}
+
 Feature::Feature(Frame &frame, cv::KeyPoint kpt, bool stereo)
     : frame_(frame),
     kpt_(kpt),
@@ -32,14 +40,29 @@ const cv::KeyPoint& Feature::GetKeypoint() const
     return kpt_;
 }
 
-const cv::Mat& Feature::GetDescriptor() const
+cv::Mat Feature::GetDescriptor() const
 {
+    if (descriptorIndex_ >= 0)
+    {
+        return frame_.GetDescriptors(stereo_).row(descriptorIndex_);
+    }
     return descriptor_;
 }
 
+int Feature::GetDescriptorIndex() const
+{
+    return descriptorIndex_;
+}
+
+bool Feature::IsStereo() const
+{
+    return stereo_;
+}
+
 void Feature::SetDescriptor(const cv::Mat& descriptor)
 {
     descriptor_ = descriptor.clone();
+    descriptorIndex_ = -1;
 }
 
 Vector3d Feature::GetBearing() const
@@ -16,11 +16,14 @@ class Feature
 {
 public:
     Feature(Frame &frame, cv::KeyPoint kpt, cv::Mat descriptor, bool stereo = false);
+    Feature(Frame &frame, cv::KeyPoint kpt, int descriptor_index, bool stereo = false);
     Feature(Frame &frame, cv::KeyPoint kpt, bool stereo = false);
 
     const Frame& GetFrame() const;
     const cv::KeyPoint& GetKeypoint() const;
-    const cv::Mat& GetDescriptor() const;
+    cv::Mat GetDescriptor() const;
+    int GetDescriptorIndex() const;
+    bool IsStereo() const;
 
     void SetDescriptor(const cv::Mat& descriptor);
 
@@ -34,6 +37,7 @@ private:
     Frame &frame_;
     cv::KeyPoint kpt_;
     cv::Mat descriptor_;
+    int descriptorIndex_{-1};
     Vector3d worldPoint_;
     Vector3d worldPointEstimate_;
     bool stereo_;
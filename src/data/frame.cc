@@ -142,7 +142,9 @@ Frame::Frame(const Frame &other)
     hasPose_(other.hasPose_),
     hasDepth_(other.hasDepth_),
     hasStereo_(other.hasStereo_),
-    isCompressed_(other.isCompressed_)
+    isCompressed_(other.isCompressed_),
+    descriptors_(other.descriptors_),
+    stereoDescriptors_(other.stereoDescriptors_)
 {
 }
 
@@ -183,6 +185,30 @@ const cv::Mat& Frame::GetStereoImage()
     return stereoImage_;
 }
 
+const std::vector<cv::Mat>& Frame::GetPyramid(const cv::Size &win_size, const int max_level)
+{
+    BuildPyramid(GetImage(), pyramid_, pyramidWinSize_, pyramidMaxLevel_, win_size, max_level);
+    return pyramid_;
+}
+
+const std::vector<cv::Mat>& Frame::GetStereoPyramid(const cv::Size &win_size, const int max_level)
+{
+    BuildPyramid(GetStereoImage(), stereoPyramid_, stereoPyramidWinSize_, stereoPyramidMaxLevel_, win_size, max_level);
+    return stereoPyramid_;
+}
+
+void Frame::BuildPyramid(const cv::Mat &image, std::vector<cv::Mat> &pyramid, cv::Size &pyramid_win_size, int &pyramid_max_level, const cv::Size &win_size, const int max_level)
+{
+    if (pyramid_max_level >= max_level && pyramid_win_size.width >= win_size.width && pyramid_win_size.height >= win_size.height)
+    {
+        return;
+    }
+    pyramid_win_size = cv::Size(std::max(pyramid_win_size.width, win_size.width), std::max(pyramid_win_size.height, win_size.height));
+    pyramid_max_level = std::max(pyramid_max_level, max_level);
+    pyramid.clear();
+    cv::buildOpticalFlowPyramid(image, pyramid, pyramid_win_size, pyramid_max_level, true);
+}
+
 const int Frame::GetID() const
 {
     return id_;
@@ -213,6 +239,16 @@ const Matrix<double, 3, 4>& Frame::GetEstimatedInversePose() const
     return invPoseEstimate_;
 }
 
+const Matrix<double, 3, 4>& Frame::GetPredictedPose() const
+{
+    return posePrediction_;
+}
+
+const Matrix<double, 3, 4>& Frame::GetPredictedInversePose() const
+{
+    return invPosePrediction_;
+}
+
 void Frame::SetPose(Matrix<double, 3, 4> &pose)
 {
     pose_ = pose;
@@ -283,6 +319,13 @@ void Frame::SetEstimatedInversePose(const Matrix<double, 3, 4> &pose)
     hasPoseEstimate_ = true;
 }
 
+void Frame::SetPredictedPose(const Matrix<double, 3, 4> &pose)
+{
+    posePrediction_ = pose;
+    invPosePrediction_ = util::TFUtil::InversePoseMatrix(pose);
+    hasPosePrediction_ = true;
+}
+
 bool Frame::HasPose() const
 {
     return hasPose_;
@@ -303,6 +346,11 @@ bool Frame::HasEstimatedPose() const
     return hasPoseEstimate_;
 }
 
+bool Frame::HasPredictedPose() const
+{
+    return hasPosePrediction_;
+}
+
 bool Frame::IsEstimatedByLandmark(const int landmark_id) const
 {
     return estLandmarkIds_.find(landmark_id) != estLandmarkIds_.end();
@@ -327,6 +375,12 @@ void Frame::CompressImages()
     image_.release();
     depthImage_.release();
     stereoImage_.release();
+    pyramid_.clear();
+    stereoPyramid_.clear();
+    pyramidWinSize_ = cv::Size();
+    stereoPyramidWinSize_ = cv::Size();
+    pyramidMaxLevel_ = -1;
+    stereoPyramidMaxLevel_ = -1;
     isCompressed_ = true;
 }
 
@@ -356,6 +410,39 @@ bool Frame::IsCompressed() const
     return isCompressed_;
 }
 
+int Frame::AddDescriptors(const cv::Mat &descriptors, bool stereo)
+{
+    cv::Mat &arena = stereo ? stereoDescriptors_ : descriptors_;
+    int start = arena.rows;
+    if (arena.empty())
+    {
+        // Never share the caller's buffer, later writes to it would silently change stored descriptors
+        arena = descriptors.clone();
+    }
+    else
+    {
+        arena.push_back(descriptors);
+    }
+    return start;
+}
+
+int Frame::AddDescriptors(cv::Mat &&descriptors, bool stereo)
+{
+    cv::Mat &arena = stereo ? stereoDescriptors_ : descriptors_;
+    if (!arena.empty())
+    {
+        return AddDescriptors(descriptors, stereo);
+    }
+    // The caller hands over its buffer, so it is adopted without a copy
+    arena = std::move(descriptors);
+    return 0;
+}
+
+const cv::Mat& Frame::GetDescriptors(bool stereo) const
+{
+    return stereo ? stereoDescriptors_ : descriptors_;
+}
+
 const double Frame::GetTime() const
 {
     return timeSec_;
@@ -31,11 +31,15 @@ public:
     const cv::Mat& GetImage();
     const cv::Mat& GetDepthImage();
     const cv::Mat& GetStereoImage();
+    const std::vector<cv::Mat>& GetPyramid(const cv::Size &win_size, const int max_level);
+    const std::vector<cv::Mat>& GetStereoPyramid(const cv::Size &win_size, const int max_level);
     const Matrix<double, 3, 4>& GetStereoPose() const;
     const camera::CameraModel<>& GetCameraModel() const;
     const camera::CameraModel<>& GetStereoCameraModel() const;
     const Matrix<double, 3, 4>& GetEstimatedPose() const;
     const Matrix<double, 3, 4>& GetEstimatedInversePose() const;
+    const Matrix<double, 3, 4>& GetPredictedPose() const;
+    const Matrix<double, 3, 4>& GetPredictedInversePose() const;
     const int GetID() const;
     const double GetTime() const;
 
@@ -43,6 +47,7 @@ public:
     bool HasDepthImage() const;
     bool HasStereoImage() const;
     bool HasEstimatedPose() const;
+    bool HasPredictedPose() const;
     bool IsEstimatedByLandmark(const int landmark_id) const;
 
     void SetPose(Matrix<double, 3, 4> &pose);
@@ -53,12 +58,19 @@ public:
     void SetEstimatedPose(const Matrix<double, 3, 4> &pose);
     void SetEstimatedInversePose(const Matrix<double, 3, 4> &pose, const std::vector<int> &landmark_ids);
     void SetEstimatedInversePose(const Matrix<double, 3, 4> &pose);
+    void SetPredictedPose(const Matrix<double, 3, 4> &pose);
 
     void CompressImages();
     void DecompressImages();
     bool IsCompressed() const;
 
+    int AddDescriptors(const cv::Mat &descriptors, bool stereo = false);
+    int AddDescriptors(cv::Mat &&descriptors, bool stereo = false);
+    const cv::Mat& GetDescriptors(bool stereo = false) const;
+
 private:
+    void BuildPyramid(const cv::Mat &image, std::vector<cv::Mat> &pyramid, cv::Size &pyramid_win_size, int &pyramid_max_level, const cv::Size &win_size, const int max_level);
+
     const int id_;
     std::vector<unsigned char> imageComp_;
     std::vector<unsigned char> depthImageComp_;
@@ -66,11 +78,21 @@ private:
     cv::Mat image_;
     cv::Mat depthImage_;
     cv::Mat stereoImage_;
+    std::vector<cv::Mat> pyramid_;
+    std::vector<cv::Mat> stereoPyramid_;
+    cv::Size pyramidWinSize_;
+    cv::Size stereoPyramidWinSize_;
+    int pyramidMaxLevel_{-1};
+    int stereoPyramidMaxLevel_{-1};
+    cv::Mat descriptors_;
+    cv::Mat stereoDescriptors_;
     Matrix<double, 3, 4> pose_;
     Matrix<double, 3, 4> invPose_;
     Matrix<double, 3, 4> stereoPose_;
     Matrix<double, 3, 4> poseEstimate_;
     Matrix<double, 3, 4> invPoseEstimate_;
+    Matrix<double, 3, 4> posePrediction_;
+    Matrix<double, 3, 4> invPosePrediction_;
     double timeSec_;
     camera::CameraModel<> &cameraModel_;
     camera::CameraModel<> *stereoCameraModel_{nullptr};
@@ -81,6 +103,7 @@ private:
     bool hasDepth_;
     bool hasStereo_;
     bool hasPoseEstimate_{false};
+    bool hasPosePrediction_{false};
 
     bool isCompressed_{false};
 
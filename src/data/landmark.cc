@@ -5,7 +5,7 @@ namespace omni_slam
 namespace data
 {
 
-int Landmark::lastLandmarkId_ = 0;
+std::atomic<int> Landmark::lastLandmarkId_(0);
 
 Landmark::Landmark()
     : id_(lastLandmarkId_++)
@@ -65,6 +65,16 @@ void Landmark::RemoveLastStereoObservation()
     idToStereoIndex_.erase(id);
 }
 
+void Landmark::Terminate()
+{
+    terminated_ = true;
+}
+
+bool Landmark::IsTerminated() const
+{
+    return terminated_;
+}
+
 const std::vector<Feature>& Landmark::GetObservations() const
 {
     return obs_;
@@ -3,6 +3,7 @@
 
 #include "feature.h"
 #include <vector>
+#include <atomic>
 #include <unordered_set>
 #include <Eigen/Dense>
 
@@ -21,6 +22,8 @@ public:
     void AddStereoObservation(Feature obs);
     void RemoveLastObservation();
     void RemoveLastStereoObservation();
+    void Terminate();
+    bool IsTerminated() const;
     const std::vector<Feature>& GetObservations() const;
     std::vector<Feature>& GetObservations();
     const std::vector<Feature>& GetStereoObservations() const;
@@ -53,8 +56,9 @@ private:
     Vector3d posEstimate_;
     bool hasGroundTruth_{false};
     bool hasPosEstimate_{false};
+    bool terminated_{false};
 
-    static int lastLandmarkId_;
+    static std::atomic<int> lastLandmarkId_;
 };
 
 }
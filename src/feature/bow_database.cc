@@ -0,0 +1,92 @@
+#include "bow_database.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace omni_slam
+{
+namespace feature
+{
+
+BowDatabase::BowDatabase(std::unique_ptr<VocabularyTree> &vocabulary)
+    : vocabulary_(std::move(vocabulary))
+{
+}
+
+BowDatabase::BowDatabase(std::unique_ptr<VocabularyTree> &&vocabulary)
+    : BowDatabase(vocabulary)
+{
+}
+
+void BowDatabase::Add(const int frame_id, const cv::Mat &descriptors)
+{
+    std::map<int, double> bow;
+    vocabulary_->Transform(descriptors, bow);
+    for (auto &entry : bow)
+    {
+        invertedFile_[entry.first].emplace_back(frame_id, entry.second);
+    }
+    size_++;
+}
+
+void BowDatabase::Query(const cv::Mat &descriptors, const int num_results, std::vector<std::pair<int, double>> &results, const int max_frame_id) const
+{
+    results.clear();
+    std::map<int, double> bow;
+    vocabulary_->Transform(descriptors, bow);
+    // L1 score, accumulated only over words shared with the query: |q - v| = |q| + |v| - (|q| + |v| - |q - v|)
+    std::unordered_map<int, double> scores;
+    for (auto &entry : bow)
+    {
+        auto it = invertedFile_.find(entry.first);
+        if (it == invertedFile_.end())
+        {
+            continue;
+        }
+        for (auto &frame : it->second)
+        {
+            if (max_frame_id >= 0 && frame.first > max_frame_id)
+            {
+                continue;
+            }
+            scores[frame.first] += entry.second + frame.second - std::abs(entry.second - frame.second);
+        }
+    }
+    results.reserve(scores.size());
+    for (auto &score : scores)
+    {
+        results.emplace_back(score.first, score.second / 2.);
+    }
+    auto cmp = [](const std::pair<int, double> &a, const std::pair<int, double> &b)
+    {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+    };
+    if (num_results > 0 && results.size() > num_results)
+    {
+        std::partial_sort(results.begin(), results.begin() + num_results, results.end(), cmp);
+        results.resize(num_results);
+    }
+    else
+    {
+        std::sort(results.begin(), results.end(), cmp);
+    }
+}
+
+void BowDatabase::Clear()
+{
+    invertedFile_.clear();
+    size_ = 0;
+}
+
+int BowDatabase::GetSize() const
+{
+    return size_;
+}
+
+VocabularyTree& BowDatabase::GetVocabulary()
+{
+    return *vocabulary_;
+}
+
+}
+}
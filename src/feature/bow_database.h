@@ -0,0 +1,39 @@
+#ifndef _BOW_DATABASE_H_
+#define _BOW_DATABASE_H_
+
+#include "vocabulary_tree.h"
+
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <vector>
+#include <map>
+#include <unordered_map>
+
+namespace omni_slam
+{
+namespace feature
+{
+
+class BowDatabase
+{
+public:
+    BowDatabase(std::unique_ptr<VocabularyTree> &vocabulary);
+    BowDatabase(std::unique_ptr<VocabularyTree> &&vocabulary);
+
+    void Add(const int frame_id, const cv::Mat &descriptors);
+    void Query(const cv::Mat &descriptors, const int num_results, std::vector<std::pair<int, double>> &results, const int max_frame_id = -1) const;
+    void Clear();
+
+    int GetSize() const;
+    VocabularyTree& GetVocabulary();
+
+private:
+    std::shared_ptr<VocabularyTree> vocabulary_;
+    std::unordered_map<int, std::vector<std::pair<int, double>>> invertedFile_;
+    int size_{0};
+};
+
+}
+}
+
+#endif /* _BOW_DATABASE_H_ */
@@ -1,16 +1,21 @@
 #include "descriptor_tracker.h"
 #include "util/tf_util.h"
 
+#include <cfloat>
+#include <cmath>
+
 namespace omni_slam
 {
 namespace feature
 {
 
-DescriptorTracker::DescriptorTracker(std::string detector_type, std::string descriptor_type, std::map<std::string, double> det_args, std::map<std::string, double> desc_args, const float match_thresh, const int keyframe_interval)
+DescriptorTracker::DescriptorTracker(std::string detector_type, std::string descriptor_type, std::map<std::string, double> det_args, std::map<std::string, double> desc_args, const float match_thresh, const int keyframe_interval, const double search_radius)
     : Tracker(keyframe_interval),
     Matcher(descriptor_type, match_thresh),
-    Detector(detector_type, descriptor_type, det_args, desc_args)
+    Detector(detector_type, descriptor_type, det_args, desc_args),
+    searchRadius_(search_radius)
 {
+    detectorPool_.reset(new DetectorPool(*static_cast<Detector*>(this)));
 }
 
 int DescriptorTracker::DoTrack(std::vector<data::Landmark> &landmarks, data::Frame &cur_frame, std::vector<double> &errors, bool stereo)
@@ -18,21 +23,33 @@ int DescriptorTracker::DoTrack(std::vector<data::Landmark> &landmarks, data::Fra
     std::vector<data::Landmark> curLandmarks;
     std::vector<data::Landmark> prevLandmarks;
     int imsize = std::max(cur_frame.GetImage().rows, cur_frame.GetImage().cols);
+    int numRegions = (Region::rs.size() - 1) * (Region::ts.size() - 1);
+    std::vector<std::vector<cv::KeyPoint>> regionKpts(numRegions);
+    std::vector<cv::Mat> regionDescs(numRegions);
+    std::vector<std::vector<cv::KeyPoint>> regionStereoKpts(numRegions);
+    std::vector<cv::Mat> regionStereoDescs(numRegions);
     #pragma omp parallel for collapse(2)
     for (int i = 0; i < Region::rs.size() - 1; i++)
     {
         for (int j = 0; j < Region::ts.size() - 1; j++)
         {
-            feature::Detector detector(*static_cast<Detector*>(this));
-            detector.DetectInRadialRegion(cur_frame, curLandmarks, feature::Region::rs[i] * imsize, feature::Region::rs[i+1] * imsize, feature::Region::ts[j], feature::Region::ts[j+1]);
-            detector.DetectInRadialRegion(cur_frame, curLandmarks, feature::Region::rs[i] * imsize, feature::Region::rs[i+1] * imsize, feature::Region::ts[j], feature::Region::ts[j+1], true);
+            int r = i * (Region::ts.size() - 1) + j;
+            Detector &detector = detectorPool_->Get();
+            detector.DetectInRadialRegion(cur_frame, regionKpts[r], regionDescs[r], feature::Region::rs[i] * imsize, feature::Region::rs[i+1] * imsize, feature::Region::ts[j], feature::Region::ts[j+1]);
+            detector.DetectInRadialRegion(cur_frame, regionStereoKpts[r], regionStereoDescs[r], feature::Region::rs[i] * imsize, feature::Region::rs[i+1] * imsize, feature::Region::ts[j], feature::Region::ts[j+1], true);
         }
     }
+    if (searchRadius_ > 0)
+    {
+        return DoGuidedTrack(landmarks, cur_frame, regionKpts, regionDescs, regionStereoKpts, regionStereoDescs, errors, stereo);
+    }
+    AddLandmarks(cur_frame, curLandmarks, regionKpts, regionDescs);
+    AddLandmarks(cur_frame, curLandmarks, regionStereoKpts, regionStereoDescs, true);
     std::vector<int> origInx;
     int i = 0;
     for (const data::Landmark &landmark : landmarks)
     {
-        if (landmark.IsObservedInFrame(keyframeId_))
+        if (!landmark.IsTerminated() && landmark.IsObservedInFrame(keyframeId_))
         {
             data::Landmark l;
             l.AddObservation(*landmark.GetObservationByFrameID(keyframeId_), false);
@@ -65,8 +82,7 @@ int DescriptorTracker::DoTrack(std::vector<data::Landmark> &landmarks, data::Fra
     for (int i = 0; i < matches.size(); i++)
     {
         data::Landmark &landmark = landmarks[origInx[indices[i]]];
-        data::Feature feat(cur_frame, matches[i].GetObservationByFrameID(cur_frame.GetID())->GetKeypoint(), matches[i].GetObservationByFrameID(cur_frame.GetID())->GetDescriptor());
-        landmark.AddObservation(feat);
+        landmark.AddObservation(*matches[i].GetObservationByFrameID(cur_frame.GetID()));
         errors.push_back(distances[i][0]);
         numGood++;
     }
@@ -77,12 +93,183 @@ int DescriptorTracker::DoTrack(std::vector<data::Landmark> &landmarks, data::Fra
         {
             continue;
         }
-        data::Feature feat(cur_frame, stereoMatches[i].GetObservationByFrameID(cur_frame.GetID())->GetKeypoint(), stereoMatches[i].GetObservationByFrameID(cur_frame.GetID())->GetDescriptor(), true);
-        landmark.AddStereoObservation(feat);
+        landmark.AddStereoObservation(*stereoMatches[i].GetObservationByFrameID(cur_frame.GetID()));
     }
 
     return numGood;
 }
 
+int DescriptorTracker::DoGuidedTrack(std::vector<data::Landmark> &landmarks, data::Frame &cur_frame, const std::vector<std::vector<cv::KeyPoint>> &region_kpts, const std::vector<cv::Mat> &region_descs, const std::vector<std::vector<cv::KeyPoint>> &region_stereo_kpts, const std::vector<cv::Mat> &region_stereo_descs, std::vector<double> &errors, bool stereo)
+{
+    std::vector<cv::KeyPoint> kpts;
+    cv::Mat descs;
+    std::vector<cv::KeyPoint> stereoKpts;
+    cv::Mat stereoDescs;
+    for (int r = 0; r < region_kpts.size(); r++)
+    {
+        if (!region_kpts[r].empty())
+        {
+            kpts.insert(kpts.end(), region_kpts[r].begin(), region_kpts[r].end());
+            descs.push_back(region_descs[r]);
+        }
+        if (!region_stereo_kpts[r].empty())
+        {
+            stereoKpts.insert(stereoKpts.end(), region_stereo_kpts[r].begin(), region_stereo_kpts[r].end());
+            stereoDescs.push_back(region_stereo_descs[r]);
+        }
+    }
+    int descStart = descs.empty() ? 0 : cur_frame.AddDescriptors(descs);
+    int stereoDescStart = stereoDescs.empty() ? 0 : cur_frame.AddDescriptors(stereoDescs, true);
+
+    std::vector<int> origInx;
+    std::vector<cv::Point2f> predicted;
+    std::vector<cv::Mat> prevDescs;
+    std::vector<int> stereoOrigInx;
+    std::vector<cv::Point2f> stereoPredicted;
+    std::vector<cv::Mat> stereoPrevDescs;
+    for (int i = 0; i < landmarks.size(); i++)
+    {
+        const data::Landmark &landmark = landmarks[i];
+        if (landmark.IsTerminated())
+        {
+            continue;
+        }
+        const data::Feature *feat = landmark.GetObservationByFrameID(keyframeId_);
+        if (feat != nullptr)
+        {
+            const data::Feature *featPrev = landmark.GetObservationByFrameID(prevId_);
+            Vector2d pixelPred;
+            if (cur_frame.HasPredictedPose() && landmark.HasEstimatedPosition() && cur_frame.GetCameraModel().ProjectToImage(util::TFUtil::WorldFrameToCameraFrame(util::TFUtil::TransformPoint(cur_frame.GetPredictedInversePose(), landmark.GetEstimatedPosition())), pixelPred))
+            {
+                predicted.push_back(cv::Point2f(pixelPred(0), pixelPred(1)));
+            }
+            else
+            {
+                predicted.push_back(featPrev != nullptr ? featPrev->GetKeypoint().pt : feat->GetKeypoint().pt);
+            }
+            prevDescs.push_back(feat->GetDescriptor());
+            origInx.push_back(i);
+        }
+        if (!stereo)
+        {
+            continue;
+        }
+        const data::Feature *stereoFeat = landmark.GetStereoObservationByFrameID(keyframeId_);
+        if (stereoFeat != nullptr)
+        {
+            const data::Feature *stereoFeatPrev = landmark.GetStereoObservationByFrameID(prevId_);
+            stereoPredicted.push_back(stereoFeatPrev != nullptr ? stereoFeatPrev->GetKeypoint().pt : stereoFeat->GetKeypoint().pt);
+            stereoPrevDescs.push_back(stereoFeat->GetDescriptor());
+            stereoOrigInx.push_back(i);
+        }
+    }
+
+    std::vector<int> matched;
+    std::vector<double> dists;
+    GuidedMatch(predicted, prevDescs, kpts, descs, cur_frame.GetImage().size(), matched, dists);
+    errors.clear();
+    int numGood = 0;
+    for (int i = 0; i < matched.size(); i++)
+    {
+        if (matched[i] < 0)
+        {
+            continue;
+        }
+        data::Feature feat(cur_frame, kpts[matched[i]], descStart + matched[i]);
+        landmarks[origInx[i]].AddObservation(feat);
+        errors.push_back(dists[i]);
+        numGood++;
+    }
+    if (stereo && cur_frame.HasStereoImage())
+    {
+        GuidedMatch(stereoPredicted, stereoPrevDescs, stereoKpts, stereoDescs, cur_frame.GetStereoImage().size(), matched, dists);
+        for (int i = 0; i < matched.size(); i++)
+        {
+            data::Landmark &landmark = landmarks[stereoOrigInx[i]];
+            if (matched[i] < 0 || !landmark.IsObservedInFrame(cur_frame.GetID()))
+            {
+                continue;
+            }
+            data::Feature feat(cur_frame, stereoKpts[matched[i]], stereoDescStart + matched[i], true);
+            landmark.AddStereoObservation(feat);
+        }
+    }
+
+    return numGood;
+}
+
+void DescriptorTracker::GuidedMatch(const std::vector<cv::Point2f> &predicted, const std::vector<cv::Mat> &prev_descs, const std::vector<cv::KeyPoint> &kpts, const cv::Mat &descs, const cv::Size &image_size, std::vector<int> &matched, std::vector<double> &dists) const
+{
+    const double cellSize = searchRadius_;
+    const int gridCols = std::max(1, (int)std::ceil(image_size.width / cellSize));
+    const int gridRows = std::max(1, (int)std::ceil(image_size.height / cellSize));
+    std::vector<std::vector<int>> grid(gridCols * gridRows);
+    for (int k = 0; k < kpts.size(); k++)
+    {
+        int cx = std::min(std::max((int)(kpts[k].pt.x / cellSize), 0), gridCols - 1);
+        int cy = std::min(std::max((int)(kpts[k].pt.y / cellSize), 0), gridRows - 1);
+        grid[cy * gridCols + cx].push_back(k);
+    }
+
+    matched.assign(predicted.size(), -1);
+    dists.assign(predicted.size(), 0.);
+    std::vector<std::vector<std::pair<int, double>>> candidates(predicted.size());
+    const double radius2 = searchRadius_ * searchRadius_;
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int i = 0; i < predicted.size(); i++)
+    {
+        const cv::Point2f &pt = predicted[i];
+        int minCx = std::max((int)std::floor((pt.x - searchRadius_) / cellSize), 0);
+        int maxCx = std::min((int)std::floor((pt.x + searchRadius_) / cellSize), gridCols - 1);
+        int minCy = std::max((int)std::floor((pt.y - searchRadius_) / cellSize), 0);
+        int maxCy = std::min((int)std::floor((pt.y + searchRadius_) / cellSize), gridRows - 1);
+        double best = DBL_MAX;
+        for (int cy = minCy; cy <= maxCy; cy++)
+        {
+            for (int cx = minCx; cx <= maxCx; cx++)
+            {
+                for (int k : grid[cy * gridCols + cx])
+                {
+                    cv::Point2f diff = kpts[k].pt - pt;
+                    if (diff.x * diff.x + diff.y * diff.y > radius2)
+                    {
+                        continue;
+                    }
+                    double dist = DescriptorDistance(prev_descs[i], descs.row(k));
+                    candidates[i].emplace_back(k, dist);
+                    if (dist < best)
+                    {
+                        best = dist;
+                        matched[i] = k;
+                        dists[i] = dist;
+                    }
+                }
+            }
+        }
+    }
+
+    // Cross-check: a detection only keeps the landmark it is closest to among those that searched it
+    std::vector<int> bestPrev(kpts.size(), -1);
+    std::vector<double> bestPrevDist(kpts.size(), DBL_MAX);
+    for (int i = 0; i < candidates.size(); i++)
+    {
+        for (const std::pair<int, double> &cand : candidates[i])
+        {
+            if (cand.second < bestPrevDist[cand.first])
+            {
+                bestPrevDist[cand.first] = cand.second;
+                bestPrev[cand.first] = i;
+            }
+        }
+    }
+    for (int i = 0; i < matched.size(); i++)
+    {
+        if (matched[i] >= 0 && (bestPrev[matched[i]] != i || (maxDistance_ > 0 && dists[i] > maxDistance_)))
+        {
+            matched[i] = -1;
+        }
+    }
+}
+
 }
 }
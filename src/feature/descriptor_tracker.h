@@ -4,12 +4,14 @@
 #include "tracker.h"
 #include "matcher.h"
 #include "detector.h"
+#include "detector_pool.h"
 #include "region.h"
 #include <opencv2/opencv.hpp>
 #include "data/frame.h"
 #include "data/landmark.h"
 #include "odometry/five_point.h"
 #include <vector>
+#include <memory>
 
 namespace omni_slam
 {
@@ -19,10 +21,15 @@ namespace feature
 class DescriptorTracker : public Tracker, public Matcher, public Detector
 {
 public:
-    DescriptorTracker(std::string detector_type, std::string descriptor_type, std::map<std::string, double> det_args, std::map<std::string, double> desc_args, const float match_thresh = 0., const int keyframe_interval = 1);
+    DescriptorTracker(std::string detector_type, std::string descriptor_type, std::map<std::string, double> det_args, std::map<std::string, double> desc_args, const float match_thresh = 0., const int keyframe_interval = 1, const double search_radius = 0.);
 
 private:
     int DoTrack(std::vector<data::Landmark> &landmarks, data::Frame &cur_frame, std::vector<double> &errors, bool stereo);
+    int DoGuidedTrack(std::vector<data::Landmark> &landmarks, data::Frame &cur_frame, const std::vector<std::vector<cv::KeyPoint>> &region_kpts, const std::vector<cv::Mat> &region_descs, const std::vector<std::vector<cv::KeyPoint>> &region_stereo_kpts, const std::vector<cv::Mat> &region_stereo_descs, std::vector<double> &errors, bool stereo);
+    void GuidedMatch(const std::vector<cv::Point2f> &predicted, const std::vector<cv::Mat> &prev_descs, const std::vector<cv::KeyPoint> &kpts, const cv::Mat &descs, const cv::Size &image_size, std::vector<int> &matched, std::vector<double> &dists) const;
+
+    std::shared_ptr<DetectorPool> detectorPool_;
+    double searchRadius_;
 };
 
 }
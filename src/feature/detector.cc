@@ -6,12 +6,13 @@ namespace omni_slam
 namespace feature
 {
 
-Detector::Detector(std::string detector_type, std::string descriptor_type, std::map<std::string, double> det_args, std::map<std::string, double> desc_args, bool local_unwarp)
+Detector::Detector(std::string detector_type, std::string descriptor_type, std::map<std::string, double> det_args, std::map<std::string, double> desc_args, bool local_unwarp, int unwarp_cache_mb)
     : detectorType_(detector_type),
     descriptorType_(descriptor_type),
     detectorArgs_(det_args),
     descriptorArgs_(desc_args),
-    localUnwarp_(local_unwarp)
+    localUnwarp_(local_unwarp),
+    unwarpCacheBytes_((size_t)std::max(unwarp_cache_mb, 0) << 20)
 {
     if (detector_type == "GFTT")
     {
@@ -424,6 +425,9 @@ Detector::Detector(std::string detector_type, std::map<std::string, double> args
 Detector::Detector(const Detector &other)
     : Detector(other.detectorType_, other.descriptorType_, other.detectorArgs_, other.descriptorArgs_, other.localUnwarp_)
 {
+    unwarpCacheBytes_ = other.unwarpCacheBytes_;
+    unwarpCache_ = other.unwarpCache_;
+    unwarpMutex_ = other.unwarpMutex_;
 }
 
 int Detector::Detect(data::Frame &frame, std::vector<data::Landmark> &landmarks, bool stereo) const
@@ -446,6 +450,14 @@ int Detector::DetectInRectangularRegion(data::Frame &frame, std::vector<data::La
 }
 
 int Detector::DetectInRadialRegion(data::Frame &frame, std::vector<data::Landmark> &landmarks, double start_r, double end_r, double start_t, double end_t, bool stereo) const
+{
+    std::vector<cv::KeyPoint> kpts;
+    cv::Mat descs;
+    DetectInRadialRegion(frame, kpts, descs, start_r, end_r, start_t, end_t, stereo);
+    return AddLandmarks(frame, landmarks, {kpts}, {descs}, stereo);
+}
+
+int Detector::DetectInRadialRegion(data::Frame &frame, std::vector<cv::KeyPoint> &kpts, cv::Mat &descs, double start_r, double end_r, double start_t, double end_t, bool stereo, const cv::Mat &free_mask) const
 {
     bool compressed = frame.IsCompressed();
     cv::Mat mask = cv::Mat::zeros(frame.GetImage().size(), CV_8U);
@@ -465,7 +477,11 @@ int Detector::DetectInRadialRegion(data::Frame &frame, std::vector<data::Landmar
             }
         }
     }
-    int count = DetectInRegion(frame, landmarks, mask, stereo);
+    if (!free_mask.empty())
+    {
+        cv::bitwise_and(mask, free_mask, mask);
+    }
+    int count = DetectInRegion(frame, kpts, descs, mask, stereo);
     if (compressed)
     {
         frame.CompressImages();
@@ -475,11 +491,23 @@ int Detector::DetectInRadialRegion(data::Frame &frame, std::vector<data::Landmar
 
 int Detector::DetectInRegion(data::Frame &frame, std::vector<data::Landmark> &landmarks, cv::Mat &mask, bool stereo) const
 {
-    bool compressed = frame.IsCompressed();
     std::vector<cv::KeyPoint> kpts;
+    cv::Mat descs;
+    DetectInRegion(frame, kpts, descs, mask, stereo);
+    return AddLandmarks(frame, landmarks, {kpts}, {descs}, stereo);
+}
+
+int Detector::DetectInRegion(data::Frame &frame, std::vector<cv::KeyPoint> &kpts, cv::Mat &descs, cv::Mat &mask, bool stereo) const
+{
+    bool compressed = frame.IsCompressed();
+    kpts.clear();
+    descs.release();
     const cv::Mat &img = stereo ? frame.GetStereoImage() : frame.GetImage();
     detector_->detect(img, kpts, mask);
-    cv::Mat descs;
+    if (maxFeatures_ > 0 && kpts.size() > maxFeatures_)
+    {
+        cv::KeyPointsFilter::retainBest(kpts, maxFeatures_);
+    }
     if (descriptor_.get() != nullptr)
     {
         if (!localUnwarp_)
@@ -498,6 +526,9 @@ int Detector::DetectInRegion(data::Frame &frame, std::vector<data::Landmark> &la
         else
         {
             std::vector<cv::KeyPoint> newKpts;
+            std::vector<cv::Mat> patches;
+            std::vector<cv::KeyPoint> patchKpts;
+            std::vector<cv::KeyPoint> origKpts;
             const camera::CameraModel<> &cam = stereo ? frame.GetStereoCameraModel() : frame.GetCameraModel();
             for (int i = 0; i < kpts.size(); i++)
             {
@@ -507,114 +538,456 @@ int Detector::DetectInRegion(data::Frame &frame, std::vector<data::Landmark> &la
                 {
                     continue;
                 }
-                Matrix3d rot = Quaterniond::FromTwoVectors(Vector3d(0, 0, 1), bearing).toRotationMatrix();
-                //cv::Point2f origin(img.cols / 2. - 0.5, img.rows / 2. - 0.5);
-                cv::Point2f origin(img.cols / 2., img.rows / 2.);
                 double size = ceil(kpts[i].size);
                 if (descriptorType_ == "BRISK")
                 {
                     size *= 4;
                 }
-                cv::Mat mapXFloat(cv::Size((int)size + 1, (int)size + 1), CV_32FC1);
-                cv::Mat mapYFloat(cv::Size((int)size + 1, (int)size + 1), CV_32FC1);
-                int j, k;
-                float x, y;
-                for (j = 0, x = origin.x - size / 2.; x <= origin.x + size / 2.; x += 1, j++)
+                // Rounding up only adds border context, and keeps continuous keypoint scales to a few table sizes
+                size = ceil(size / unwarpSizeStep_) * unwarpSizeStep_;
+                std::shared_ptr<const UnwarpMap> unwarpPtr = GetUnwarpMap(cam, img.size(), kpts[i].pt, (int)size);
+                const UnwarpMap &unwarp = *unwarpPtr;
+                cv::Rect roi = cv::Rect((int)floor(kpts[i].pt.x - unwarp.extent), (int)floor(kpts[i].pt.y - unwarp.extent), 2 * (int)ceil(unwarp.extent) + 2, 2 * (int)ceil(unwarp.extent) + 2) & cv::Rect(0, 0, img.cols, img.rows);
+                if (roi.area() == 0)
                 {
-                    for (k = 0, y = origin.y - size / 2.; y <= origin.y + size / 2.; y += 1, k++)
-                    {
-                        Vector3d normPix;
-                        Vector2d virtPix(x, y);
-                        cam.UnprojectToBearing(virtPix, normPix);
-                        Vector3d rotPix = rot * normPix;
-                        double undistX = -1;
-                        double undistY = -1;
-                        Vector2d proj;
-                        if (cam.ProjectToImage(rotPix, proj))
-                        {
-                            undistX = proj(0);
-                            undistY = proj(1);
-                        }
-                        mapXFloat.at<float>(k, j) = undistX;
-                        mapYFloat.at<float>(k, j) = undistY;
-                    }
+                    continue;
                 }
-                cv::Mat mapX;
-                cv::Mat mapY;
-                cv::convertMaps(mapXFloat, mapYFloat, mapX, mapY, CV_16SC2);
-                cv::Mat cropped;
-                cv::getRectSubPix(img, cv::Size((int)size, (int)size), kpts[i].pt, cropped);
+                cv::Mat mapX = unwarp.mapX + (kpts[i].pt.x - unwarp.center.x - roi.x);
+                cv::Mat mapY = unwarp.mapY + (kpts[i].pt.y - unwarp.center.y - roi.y);
                 cv::Mat undist;
-                cv::remap(img, undist, mapX, mapY, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
-                //cv::imshow("undist", undist);
-                //cv::imshow("cropped", cropped);
-                //cv::waitKey(0);
+                cv::remap(img(roi), undist, mapX, mapY, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
                 cv::KeyPoint kpt = kpts[i];
                 kpt.pt = cv::Point2f(size / 2., size / 2.);
                 if (descriptorType_ == "AKAZE" || descriptorType_ == "KAZE")
                 {
                     kpt.class_id = 0;
                 }
-                std::vector<cv::KeyPoint> kptsTmp{kpt};
-                cv::Mat descsTmp;
+                patches.push_back(undist);
+                patchKpts.push_back(kpt);
+                origKpts.push_back(kpts[i]);
+            }
+            if (!patches.empty())
+            {
+                int cellSize = 0;
+                for (const cv::Mat &patch : patches)
+                {
+                    cellSize = std::max(cellSize, std::max(patch.cols, patch.rows));
+                }
+                // Zero padding around each tile must cover the extractor's full reach, or samples land in neighbouring patches
+                int margin = cellSize / 2;
+                for (int t = 0; t < patches.size(); t++)
+                {
+                    margin = std::max(margin, (int)ceil(GetDescriptorSupportRadius(patchKpts[t]) - std::min(patches[t].cols, patches[t].rows) / 2.) + 1);
+                }
+                cellSize += 2 * margin;
+                int gridCols = (int)ceil(sqrt((double)patches.size()));
+                int gridRows = (patches.size() + gridCols - 1) / gridCols;
+                cv::Mat atlas = cv::Mat::zeros(gridRows * cellSize, gridCols * cellSize, img.type());
+                std::vector<cv::KeyPoint> atlasKpts;
+                atlasKpts.reserve(patches.size());
+                for (int t = 0; t < patches.size(); t++)
+                {
+                    cv::Point tl((t % gridCols) * cellSize + margin, (t / gridCols) * cellSize + margin);
+                    patches[t].copyTo(atlas(cv::Rect(tl.x, tl.y, patches[t].cols, patches[t].rows)));
+                    cv::KeyPoint kpt = patchKpts[t];
+                    kpt.pt += cv::Point2f(tl.x, tl.y);
+                    atlasKpts.push_back(kpt);
+                }
+                cv::Mat atlasDescs;
                 if (descriptorType_ == "LUCID")
                 {
                     cv::Mat rgb;
-                    cv::cvtColor(undist, rgb, cv::COLOR_GRAY2BGR);
-                    descriptor_->compute(rgb, kptsTmp, descsTmp);
+                    cv::cvtColor(atlas, rgb, cv::COLOR_GRAY2BGR);
+                    descriptor_->compute(rgb, atlasKpts, atlasDescs);
                 }
                 else
                 {
-                    descriptor_->compute(undist, kptsTmp, descsTmp);
+                    descriptor_->compute(atlas, atlasKpts, atlasDescs);
+                }
+                std::vector<int> tileRows(patches.size(), -1);
+                int count = 0;
+                for (int j = 0; j < atlasKpts.size(); j++)
+                {
+                    int col = (int)(atlasKpts[j].pt.x / cellSize);
+                    int row = (int)(atlasKpts[j].pt.y / cellSize);
+                    int tile = row * gridCols + col;
+                    if (col >= 0 && col < gridCols && tile >= 0 && tile < patches.size() && tileRows[tile] < 0)
+                    {
+                        tileRows[tile] = j;
+                        count++;
+                    }
                 }
-                for (int j = 0; j < kptsTmp.size(); j++)
+                descs.create(count, atlasDescs.cols, atlasDescs.type());
+                newKpts.reserve(count);
+                for (int t = 0; t < patches.size(); t++)
                 {
-                    descs.push_back(descsTmp.row(j));
-                    newKpts.push_back(kpts[i]);
+                    if (tileRows[t] >= 0)
+                    {
+                        atlasDescs.row(tileRows[t]).copyTo(descs.row(newKpts.size()));
+                        newKpts.push_back(origKpts[t]);
+                    }
                 }
             }
             kpts = newKpts;
         }
     }
-    for (int i = 0; i < kpts.size(); i++)
+    if (compressed)
+    {
+        frame.CompressImages();
+    }
+    return kpts.size();
+}
+
+int Detector::Describe(const cv::Mat &image, std::vector<cv::KeyPoint> &kpts, cv::Mat &descs) const
+{
+    descs.release();
+    if (descriptor_.get() == nullptr || kpts.empty())
+    {
+        kpts.clear();
+        return 0;
+    }
+    if (descriptorType_ == "LUCID")
+    {
+        cv::Mat rgb;
+        cv::cvtColor(image, rgb, cv::COLOR_GRAY2BGR);
+        descriptor_->compute(rgb, kpts, descs);
+    }
+    else
     {
-        cv::KeyPoint &kpt = kpts[i];
-        data::Landmark landmark;
-        if (descriptor_.get() != nullptr)
+        descriptor_->compute(image, kpts, descs);
+    }
+    return kpts.size();
+}
+
+int Detector::AddLandmarks(data::Frame &frame, std::vector<data::Landmark> &landmarks, const std::vector<std::vector<cv::KeyPoint>> &kpts, const std::vector<cv::Mat> &descs, bool stereo)
+{
+    int count = 0;
+    for (const std::vector<cv::KeyPoint> &batch : kpts)
+    {
+        count += batch.size();
+    }
+    if (count == 0)
+    {
+        return 0;
+    }
+    bool compressed = frame.IsCompressed();
+    if (compressed)
+    {
+        frame.GetImage();
+    }
+    // Descriptors of all batches go into the frame's arena in one block; features refer to their rows
+    int descCount = 0;
+    int descCols = 0;
+    int descType = -1;
+    for (int b = 0; b < kpts.size(); b++)
+    {
+        if (!descs[b].empty())
         {
-            cv::Mat desc = descs.row(i);
-            data::Feature feat(frame, kpt, desc, stereo);
-            if (stereo)
+            descCount += descs[b].rows;
+            descCols = descs[b].cols;
+            descType = descs[b].type();
+        }
+    }
+    std::vector<int> descStart(kpts.size(), -1);
+    if (descCount > 0)
+    {
+        cv::Mat arena(descCount, descCols, descType);
+        int row = 0;
+        for (int b = 0; b < kpts.size(); b++)
+        {
+            if (!descs[b].empty())
             {
-                landmark.AddStereoObservation(feat);
+                descs[b].copyTo(arena.rowRange(row, row + descs[b].rows));
+                descStart[b] = row;
+                row += descs[b].rows;
             }
-            else
+        }
+        int arenaStart = frame.AddDescriptors(std::move(arena), stereo);
+        for (int &start : descStart)
+        {
+            if (start >= 0)
             {
-                landmark.AddObservation(feat);
+                start += arenaStart;
             }
         }
-        else
+    }
+    landmarks.reserve(landmarks.size() + count);
+    for (int b = 0; b < kpts.size(); b++)
+    {
+        for (int i = 0; i < kpts[b].size(); i++)
         {
-            data::Feature feat(frame, kpt, stereo);
-            if (stereo)
+            const cv::KeyPoint &kpt = kpts[b][i];
+            data::Landmark landmark;
+            if (descStart[b] >= 0)
             {
-                landmark.AddStereoObservation(feat);
+                data::Feature feat(frame, kpt, descStart[b] + i, stereo);
+                if (stereo)
+                {
+                    landmark.AddStereoObservation(feat);
+                }
+                else
+                {
+                    landmark.AddObservation(feat);
+                }
             }
             else
             {
-                landmark.AddObservation(feat);
+                data::Feature feat(frame, kpt, stereo);
+                if (stereo)
+                {
+                    landmark.AddStereoObservation(feat);
+                }
+                else
+                {
+                    landmark.AddObservation(feat);
+                }
             }
-        }
-        #pragma omp critical
-        {
-            landmarks.push_back(landmark);
+            landmarks.push_back(std::move(landmark));
         }
     }
     if (compressed)
     {
         frame.CompressImages();
     }
-    return kpts.size();
+    return count;
+}
+
+std::shared_ptr<const Detector::UnwarpMap> Detector::GetUnwarpMap(const camera::CameraModel<> &camera_model, const cv::Size &image_size, const cv::Point2f &pt, const int size) const
+{
+    int cellX = (int)floor(pt.x / unwarpCellSize_);
+    int cellY = (int)floor(pt.y / unwarpCellSize_);
+    UnwarpKey key(&camera_model, size, cellX, cellY);
+    {
+        std::lock_guard<std::mutex> lock(*unwarpMutex_);
+        auto it = unwarpCache_->maps.find(key);
+        if (it != unwarpCache_->maps.end())
+        {
+            unwarpCache_->order.splice(unwarpCache_->order.begin(), unwarpCache_->order, it->second.second);
+            return it->second.first;
+        }
+    }
+
+    std::shared_ptr<UnwarpMap> unwarpPtr = std::make_shared<UnwarpMap>();
+    UnwarpMap &unwarp = *unwarpPtr;
+    unwarp.center = cv::Point2f((cellX + 0.5) * unwarpCellSize_, (cellY + 0.5) * unwarpCellSize_);
+    unwarp.extent = 0;
+    unwarp.mapX = cv::Mat(cv::Size(size + 1, size + 1), CV_32FC1);
+    unwarp.mapY = cv::Mat(cv::Size(size + 1, size + 1), CV_32FC1);
+    Vector3d bearing;
+    Matrix3d rot = Matrix3d::Identity();
+    if (camera_model.UnprojectToBearing(Vector2d(unwarp.center.x, unwarp.center.y), bearing))
+    {
+        rot = Quaterniond::FromTwoVectors(Vector3d(0, 0, 1), bearing).toRotationMatrix();
+    }
+    cv::Point2f origin(image_size.width / 2., image_size.height / 2.);
+    for (int j = 0; j <= size; j++)
+    {
+        for (int k = 0; k <= size; k++)
+        {
+            Vector3d normPix;
+            Vector2d virtPix(origin.x - size / 2. + j, origin.y - size / 2. + k);
+            Vector2d proj;
+            // Invalid samples are pushed far outside any ROI so that per-keypoint offsets keep them invalid
+            float undistX = -1e6;
+            float undistY = -1e6;
+            if (camera_model.UnprojectToBearing(virtPix, normPix) && camera_model.ProjectToImage(rot * normPix, proj))
+            {
+                undistX = proj(0);
+                undistY = proj(1);
+                unwarp.extent = std::max(unwarp.extent, std::max(std::abs(undistX - unwarp.center.x), std::abs(undistY - unwarp.center.y)));
+            }
+            unwarp.mapX.at<float>(k, j) = undistX;
+            unwarp.mapY.at<float>(k, j) = undistY;
+        }
+    }
+    unwarp.extent += unwarpCellSize_;
+
+    std::lock_guard<std::mutex> lock(*unwarpMutex_);
+    auto it = unwarpCache_->maps.find(key);
+    if (it != unwarpCache_->maps.end())
+    {
+        return it->second.first;
+    }
+    // Least recently used tables are evicted once the byte budget is reached, callers keep theirs alive through the shared pointer
+    const size_t bytes = UnwarpMapBytes(unwarp);
+    while (!unwarpCache_->maps.empty() && unwarpCache_->bytes + bytes > unwarpCacheBytes_)
+    {
+        auto evictIt = unwarpCache_->maps.find(unwarpCache_->order.back());
+        unwarpCache_->bytes -= UnwarpMapBytes(*evictIt->second.first);
+        unwarpCache_->maps.erase(evictIt);
+        unwarpCache_->order.pop_back();
+    }
+    if (bytes > unwarpCacheBytes_)
+    {
+        return unwarpPtr;
+    }
+    unwarpCache_->order.push_front(key);
+    unwarpCache_->maps.emplace(key, std::make_pair(std::shared_ptr<const UnwarpMap>(unwarpPtr), unwarpCache_->order.begin()));
+    unwarpCache_->bytes += bytes;
+    return unwarpPtr;
+}
+
+size_t Detector::UnwarpMapBytes(const UnwarpMap &unwarp)
+{
+    return unwarp.mapX.total() * unwarp.mapX.elemSize() + unwarp.mapY.total() * unwarp.mapY.elemSize();
+}
+
+float Detector::GetDescriptorSupportRadius(const cv::KeyPoint &kpt) const
+{
+    // Approximate sampling reach of each extractor around a keypoint, including pattern rotation and smoothing
+    auto arg = [this](const std::string &name, const double def)
+    {
+        auto it = descriptorArgs_.find(name);
+        return it != descriptorArgs_.end() ? it->second : def;
+    };
+    if (descriptorType_ == "SIFT")
+    {
+        return 5.4 * kpt.size;
+    }
+    else if (descriptorType_ == "SURF")
+    {
+        return 2. * kpt.size;
+    }
+    else if (descriptorType_ == "ORB")
+    {
+        return arg("patchSize", 31) * M_SQRT1_2 + 1;
+    }
+    else if (descriptorType_ == "BRISK")
+    {
+        return 1.5 * arg("patternScale", 1.) * kpt.size;
+    }
+    else if (descriptorType_ == "AKAZE")
+    {
+        return 7.1 * kpt.size;
+    }
+    else if (descriptorType_ == "KAZE")
+    {
+        return 8.5 * kpt.size;
+    }
+    else if (descriptorType_ == "FREAK")
+    {
+        return std::max(2.5 * kpt.size, 18.) * arg("patternScale", 22.) / 22.;
+    }
+    else if (descriptorType_ == "DAISY")
+    {
+        return arg("radius", 15) + 5;
+    }
+    else if (descriptorType_ == "LATCH")
+    {
+        return 24 * M_SQRT2 + arg("half_ssd_size", 3);
+    }
+    else if (descriptorType_ == "LUCID")
+    {
+        return arg("lucid_kernel", 1) + arg("blur_kernel", 2) + 1;
+    }
+    else if (descriptorType_ == "VGG")
+    {
+        return M_SQRT1_2 * arg("scale_factor", 6.25) * kpt.size;
+    }
+    else if (descriptorType_ == "BOOST")
+    {
+        return M_SQRT1_2 * 6.75 * kpt.size;
+    }
+    return kpt.size;
+}
+
+bool Detector::GetThreshold(double &threshold) const
+{
+    if (detectorType_ == "GFTT")
+    {
+        threshold = detector_.dynamicCast<cv::GFTTDetector>()->getQualityLevel();
+    }
+    else if (detectorType_ == "FAST")
+    {
+        threshold = detector_.dynamicCast<cv::FastFeatureDetector>()->getThreshold();
+    }
+    else if (detectorType_ == "AGAST")
+    {
+        threshold = detector_.dynamicCast<cv::AgastFeatureDetector>()->getThreshold();
+    }
+    else if (detectorType_ == "ORB")
+    {
+        threshold = detector_.dynamicCast<cv::ORB>()->getFastThreshold();
+    }
+    else if (detectorType_ == "AKAZE")
+    {
+        threshold = detector_.dynamicCast<cv::AKAZE>()->getThreshold();
+    }
+    else if (detectorType_ == "KAZE")
+    {
+        threshold = detector_.dynamicCast<cv::KAZE>()->getThreshold();
+    }
+    else if (detectorType_ == "SURF")
+    {
+        threshold = detector_.dynamicCast<cv::xfeatures2d::SURF>()->getHessianThreshold();
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool Detector::SetThreshold(const double threshold)
+{
+    if (detectorType_ == "GFTT")
+    {
+        detector_.dynamicCast<cv::GFTTDetector>()->setQualityLevel(threshold);
+    }
+    else if (detectorType_ == "FAST")
+    {
+        detector_.dynamicCast<cv::FastFeatureDetector>()->setThreshold((int)round(threshold));
+    }
+    else if (detectorType_ == "AGAST")
+    {
+        detector_.dynamicCast<cv::AgastFeatureDetector>()->setThreshold((int)round(threshold));
+    }
+    else if (detectorType_ == "ORB")
+    {
+        detector_.dynamicCast<cv::ORB>()->setFastThreshold((int)round(threshold));
+    }
+    else if (detectorType_ == "AKAZE")
+    {
+        detector_.dynamicCast<cv::AKAZE>()->setThreshold(threshold);
+    }
+    else if (detectorType_ == "KAZE")
+    {
+        detector_.dynamicCast<cv::KAZE>()->setThreshold(threshold);
+    }
+    else if (detectorType_ == "SURF")
+    {
+        detector_.dynamicCast<cv::xfeatures2d::SURF>()->setHessianThreshold(threshold);
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool Detector::IsThresholdIntegral() const
+{
+    return detectorType_ == "FAST" || detectorType_ == "AGAST" || detectorType_ == "ORB";
+}
+
+void Detector::SetMaxFeatures(const int max_features)
+{
+    maxFeatures_ = max_features;
+    // The budget can only tighten the configured limit, a budget of 0 restores it
+    if (detectorType_ == "GFTT")
+    {
+        auto it = detectorArgs_.find("maxCorners");
+        int configured = it != detectorArgs_.end() ? (int)it->second : 0;
+        int limit = configured > 0 && (max_features <= 0 || configured < max_features) ? configured : std::max(max_features, 0);
+        detector_.dynamicCast<cv::GFTTDetector>()->setMaxFeatures(limit);
+    }
+    else if (detectorType_ == "ORB")
+    {
+        auto it = detectorArgs_.find("nfeatures");
+        int configured = it != detectorArgs_.end() ? (int)it->second : 500;
+        int limit = max_features > 0 ? std::min(max_features, configured) : configured;
+        detector_.dynamicCast<cv::ORB>()->setMaxFeatures(limit);
+    }
 }
 
 std::string Detector::GetDetectorType()
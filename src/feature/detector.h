@@ -7,6 +7,11 @@
 #include "data/landmark.h"
 #include <string>
 #include <vector>
+#include <map>
+#include <list>
+#include <tuple>
+#include <mutex>
+#include <memory>
 
 namespace omni_slam
 {
@@ -53,13 +58,24 @@ public:
         }
     }
     Detector(std::string detector_type, std::map<std::string, double> args);
-    Detector(std::string detector_type, std::string descriptor_type, std::map<std::string, double> det_args, std::map<std::string, double> desc_args, bool local_unwarp = false);
+    Detector(std::string detector_type, std::string descriptor_type, std::map<std::string, double> det_args, std::map<std::string, double> desc_args, bool local_unwarp = false, int unwarp_cache_mb = 64);
     Detector(const Detector &other);
 
     int Detect(data::Frame &frame, std::vector<data::Landmark> &landmarks, bool stereo = false) const;
     int DetectInRectangularRegion(data::Frame &frame, std::vector<data::Landmark> &landmarks, cv::Point2f start, cv::Point2f end, bool stereo = false) const;
     int DetectInRadialRegion(data::Frame &frame, std::vector<data::Landmark> &landmarks, double start_r, double end_r, double start_t, double end_t, bool stereo = false) const;
+    int DetectInRadialRegion(data::Frame &frame, std::vector<cv::KeyPoint> &kpts, cv::Mat &descs, double start_r, double end_r, double start_t, double end_t, bool stereo = false, const cv::Mat &free_mask = cv::Mat()) const;
     int DetectInRegion(data::Frame &frame, std::vector<data::Landmark> &landmarks, cv::Mat &mask, bool stereo = false) const;
+    int DetectInRegion(data::Frame &frame, std::vector<cv::KeyPoint> &kpts, cv::Mat &descs, cv::Mat &mask, bool stereo = false) const;
+
+    int Describe(const cv::Mat &image, std::vector<cv::KeyPoint> &kpts, cv::Mat &descs) const;
+
+    static int AddLandmarks(data::Frame &frame, std::vector<data::Landmark> &landmarks, const std::vector<std::vector<cv::KeyPoint>> &kpts, const std::vector<cv::Mat> &descs, bool stereo = false);
+
+    bool GetThreshold(double &threshold) const;
+    bool SetThreshold(const double threshold);
+    bool IsThresholdIntegral() const;
+    void SetMaxFeatures(const int max_features);
 
     std::string GetDetectorType();
     std::string GetDescriptorType();
@@ -69,6 +85,27 @@ public:
     static bool IsDetectorDescriptorCombinationValid(std::string det, std::string desc);
 
 private:
+    struct UnwarpMap
+    {
+        cv::Mat mapX;
+        cv::Mat mapY;
+        cv::Point2f center;
+        float extent;
+    };
+
+    typedef std::tuple<const camera::CameraModel<>*, int, int, int> UnwarpKey;
+
+    struct UnwarpCache
+    {
+        std::list<UnwarpKey> order;
+        std::map<UnwarpKey, std::pair<std::shared_ptr<const UnwarpMap>, std::list<UnwarpKey>::iterator>> maps;
+        size_t bytes{0};
+    };
+
+    float GetDescriptorSupportRadius(const cv::KeyPoint &kpt) const;
+    static size_t UnwarpMapBytes(const UnwarpMap &unwarp);
+    std::shared_ptr<const UnwarpMap> GetUnwarpMap(const camera::CameraModel<> &camera_model, const cv::Size &image_size, const cv::Point2f &pt, const int size) const;
+
     cv::Ptr<cv::Feature2D> detector_;
     cv::Ptr<cv::Feature2D> descriptor_;
     std::string detectorType_;
@@ -78,6 +115,12 @@ private:
     std::map<std::string, double> descriptorArgs_;
 
     bool localUnwarp_{false};
+    int maxFeatures_{0};
+    const int unwarpCellSize_{8};
+    const int unwarpSizeStep_{4};
+    size_t unwarpCacheBytes_{(size_t)64 << 20};
+    std::shared_ptr<UnwarpCache> unwarpCache_{std::make_shared<UnwarpCache>()};
+    std::shared_ptr<std::mutex> unwarpMutex_{std::make_shared<std::mutex>()};
 };
 
 }
@@ -0,0 +1,52 @@
+#include "detector_pool.h"
+
+#include <omp.h>
+#include <algorithm>
+#include <unordered_map>
+
+namespace omni_slam
+{
+namespace feature
+{
+
+std::atomic<unsigned long> DetectorPool::nextId_{0};
+
+DetectorPool::DetectorPool(const Detector &detector)
+    : prototype_(detector),
+    id_(nextId_++)
+{
+    int numThreads = std::max(omp_get_max_threads(), 1);
+    detectors_.reserve(numThreads);
+    for (int i = 0; i < numThreads; i++)
+    {
+        detectors_.emplace_back(new Detector(detector));
+    }
+}
+
+Detector& DetectorPool::Get()
+{
+    // Keyed by pool id rather than address, which a later pool could reuse
+    thread_local std::unordered_map<unsigned long, Detector*> slots;
+    auto it = slots.find(id_);
+    if (it != slots.end())
+    {
+        return *it->second;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (numAssigned_ == detectors_.size())
+    {
+        detectors_.emplace_back(new Detector(prototype_));
+    }
+    Detector *detector = detectors_[numAssigned_++].get();
+    slots[id_] = detector;
+    return *detector;
+}
+
+int DetectorPool::GetSize() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return detectors_.size();
+}
+
+}
+}
@@ -0,0 +1,43 @@
+#ifndef _DETECTOR_POOL_H_
+#define _DETECTOR_POOL_H_
+
+#include "detector.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+namespace omni_slam
+{
+namespace feature
+{
+
+// OpenCV backends differ in reentrancy: GFTT, FAST, AGAST, SIFT, SURF, ORB,
+// BRISK, KAZE and AKAZE keep no state between calls, while FREAK and DAISY
+// cache sampling patterns and image data inside the extractor, and LATCH,
+// LUCID, VGG and BOOST make no guarantees. The pool therefore gives every
+// thread its own Detector regardless of backend. Slots are bound to OS threads
+// on first use, so nested regions and teams larger than the initial pool never
+// share one.
+class DetectorPool
+{
+public:
+    DetectorPool(const Detector &detector);
+
+    Detector& Get();
+    int GetSize() const;
+
+private:
+    const Detector prototype_;
+    std::vector<std::unique_ptr<Detector>> detectors_;
+    int numAssigned_{0};
+    const unsigned long id_;
+    mutable std::mutex mutex_;
+
+    static std::atomic<unsigned long> nextId_;
+};
+
+}
+}
+
+#endif /* _DETECTOR_POOL_H_ */
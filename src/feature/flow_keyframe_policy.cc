@@ -0,0 +1,36 @@
+#include "flow_keyframe_policy.h"
+
+#include <algorithm>
+
+namespace omni_slam
+{
+namespace feature
+{
+
+FlowKeyframePolicy::FlowKeyframePolicy(const double max_flow)
+    : maxFlow_(max_flow)
+{
+}
+
+bool FlowKeyframePolicy::IsKeyframe(const std::vector<data::Landmark> &landmarks, const data::Frame &keyframe, const data::Frame &cur_frame, const int frames_since_keyframe) const
+{
+    std::vector<double> flows;
+    for (const data::Landmark &landmark : landmarks)
+    {
+        const data::Feature *feat = landmark.GetObservationByFrameID(keyframe.GetID());
+        const data::Feature *curFeat = landmark.GetObservationByFrameID(cur_frame.GetID());
+        if (feat != nullptr && curFeat != nullptr)
+        {
+            flows.push_back(cv::norm(curFeat->GetKeypoint().pt - feat->GetKeypoint().pt));
+        }
+    }
+    if (flows.size() == 0)
+    {
+        return true;
+    }
+    std::nth_element(flows.begin(), flows.begin() + flows.size() / 2, flows.end());
+    return flows[flows.size() / 2] >= maxFlow_;
+}
+
+}
+}
@@ -0,0 +1,25 @@
+#ifndef _FLOW_KEYFRAME_POLICY_H_
+#define _FLOW_KEYFRAME_POLICY_H_
+
+#include "keyframe_policy.h"
+
+namespace omni_slam
+{
+namespace feature
+{
+
+class FlowKeyframePolicy : public KeyframePolicy
+{
+public:
+    FlowKeyframePolicy(const double max_flow);
+
+    bool IsKeyframe(const std::vector<data::Landmark> &landmarks, const data::Frame &keyframe, const data::Frame &cur_frame, const int frames_since_keyframe) const;
+
+private:
+    const double maxFlow_;
+};
+
+}
+}
+
+#endif /* _FLOW_KEYFRAME_POLICY_H_ */
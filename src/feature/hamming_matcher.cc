@@ -0,0 +1,257 @@
+#include "hamming_matcher.h"
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define OMNI_SLAM_X86_DISPATCH
+#endif
+
+namespace
+{
+
+// Distances from one query descriptor to a run of train rows. Each variant is compiled for its own instruction set
+// and picked at runtime, so the default build does not depend on -march flags.
+inline int PopcountDistance(const unsigned char *a, const unsigned char *b, int i, const int num_bytes)
+{
+    int dist = 0;
+    for (; i + 8 <= num_bytes; i += 8)
+    {
+        std::uint64_t x;
+        std::uint64_t y;
+        std::memcpy(&x, a + i, 8);
+        std::memcpy(&y, b + i, 8);
+        dist += __builtin_popcountll(x ^ y);
+    }
+    for (; i < num_bytes; i++)
+    {
+        dist += __builtin_popcount(a[i] ^ b[i]);
+    }
+    return dist;
+}
+
+void ScanGeneric(const unsigned char *query, const unsigned char *train, const size_t step, const int rows, const int num_bytes, int *dists)
+{
+    for (int t = 0; t < rows; t++)
+    {
+        dists[t] = PopcountDistance(query, train + t * step, 0, num_bytes);
+    }
+}
+
+#ifdef OMNI_SLAM_X86_DISPATCH
+__attribute__((target("popcnt")))
+void ScanPopcnt(const unsigned char *query, const unsigned char *train, const size_t step, const int rows, const int num_bytes, int *dists)
+{
+    for (int t = 0; t < rows; t++)
+    {
+        dists[t] = PopcountDistance(query, train + t * step, 0, num_bytes);
+    }
+}
+
+__attribute__((target("avx2,popcnt")))
+void ScanAVX2(const unsigned char *query, const unsigned char *train, const size_t step, const int rows, const int num_bytes, int *dists)
+{
+    // Per-nibble popcount lookup, summed per 64-bit lane with SAD
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowMask = _mm256_set1_epi8(0x0f);
+    for (int t = 0; t < rows; t++)
+    {
+        const unsigned char *b = train + t * step;
+        __m256i acc = _mm256_setzero_si256();
+        int i = 0;
+        for (; i + 32 <= num_bytes; i += 32)
+        {
+            __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(query + i)), _mm256_loadu_si256((const __m256i*)(b + i)));
+            __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(x, lowMask));
+            __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(x, 4), lowMask));
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+        }
+        int dist = (int)(_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) + _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+        dists[t] = dist + PopcountDistance(query, b, i, num_bytes);
+    }
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq,avx2,popcnt")))
+void ScanAVX512(const unsigned char *query, const unsigned char *train, const size_t step, const int rows, const int num_bytes, int *dists)
+{
+    if (num_bytes < 64)
+    {
+        ScanAVX2(query, train, step, rows, num_bytes, dists);
+        return;
+    }
+    for (int t = 0; t < rows; t++)
+    {
+        const unsigned char *b = train + t * step;
+        __m512i acc = _mm512_setzero_si512();
+        int i = 0;
+        for (; i + 64 <= num_bytes; i += 64)
+        {
+            __m512i x = _mm512_xor_si512(_mm512_loadu_si512(query + i), _mm512_loadu_si512(b + i));
+            acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(x));
+        }
+        alignas(64) long long lanes[8];
+        _mm512_store_si512(lanes, acc);
+        int dist = (int)(lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7]);
+        dists[t] = dist + PopcountDistance(query, b, i, num_bytes);
+    }
+}
+#endif
+
+int SelectKernelLevel()
+{
+#ifdef OMNI_SLAM_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq"))
+    {
+        return 3;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+    {
+        return 2;
+    }
+    if (__builtin_cpu_supports("popcnt"))
+    {
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+typedef void (*ScanKernel)(const unsigned char*, const unsigned char*, const size_t, const int, const int, int*);
+
+ScanKernel GetScanKernel()
+{
+    static const ScanKernel kernel = []() -> ScanKernel
+    {
+        switch (SelectKernelLevel())
+        {
+#ifdef OMNI_SLAM_X86_DISPATCH
+            case 3:
+                return ScanAVX512;
+            case 2:
+                return ScanAVX2;
+            case 1:
+                return ScanPopcnt;
+#endif
+            default:
+                return ScanGeneric;
+        }
+    }();
+    return kernel;
+}
+
+}
+
+namespace omni_slam
+{
+namespace feature
+{
+
+HammingMatcher::HammingMatcher(const bool cross_check)
+    : crossCheck_(cross_check)
+{
+}
+
+void HammingMatcher::Match(const cv::Mat &query, const cv::Mat &train, std::vector<cv::DMatch> &matches, std::vector<float> *second_distances) const
+{
+    matches.clear();
+    if (second_distances != nullptr)
+    {
+        second_distances->clear();
+    }
+    if (query.empty() || train.empty())
+    {
+        return;
+    }
+
+    std::vector<int> bestDist(query.rows, INT_MAX);
+    std::vector<int> bestIdx(query.rows, -1);
+    std::vector<int> secondDist(query.rows, INT_MAX);
+    std::vector<int> colDist(crossCheck_ ? train.rows : 0, INT_MAX);
+    std::vector<int> colIdx(crossCheck_ ? train.rows : 0, -1);
+    const ScanKernel kernel = GetScanKernel();
+    #pragma omp parallel
+    {
+        // Best query per train row, gathered in the same pass so the reverse check needs no second distance sweep
+        std::vector<int> threadColDist(colDist.size(), INT_MAX);
+        std::vector<int> threadColIdx(colIdx.size(), -1);
+        std::vector<int> dists(train.rows);
+        #pragma omp for schedule(static)
+        for (int q = 0; q < query.rows; q++)
+        {
+            kernel(query.ptr<unsigned char>(q), train.ptr<unsigned char>(), train.step, train.rows, query.cols, dists.data());
+            int best = INT_MAX;
+            int second = INT_MAX;
+            int idx = -1;
+            for (int t = 0; t < train.rows; t++)
+            {
+                int dist = dists[t];
+                if (dist < best)
+                {
+                    second = best;
+                    best = dist;
+                    idx = t;
+                }
+                else if (dist < second)
+                {
+                    second = dist;
+                }
+                if (crossCheck_ && dist < threadColDist[t])
+                {
+                    threadColDist[t] = dist;
+                    threadColIdx[t] = q;
+                }
+            }
+            bestDist[q] = best;
+            bestIdx[q] = idx;
+            secondDist[q] = second;
+        }
+        if (crossCheck_)
+        {
+            #pragma omp critical
+            {
+                for (int t = 0; t < train.rows; t++)
+                {
+                    if (threadColIdx[t] >= 0 && (threadColDist[t] < colDist[t] || (threadColDist[t] == colDist[t] && threadColIdx[t] < colIdx[t])))
+                    {
+                        colDist[t] = threadColDist[t];
+                        colIdx[t] = threadColIdx[t];
+                    }
+                }
+            }
+        }
+    }
+
+    matches.reserve(query.rows);
+    for (int q = 0; q < query.rows; q++)
+    {
+        if (bestIdx[q] < 0 || (crossCheck_ && colIdx[bestIdx[q]] != q))
+        {
+            continue;
+        }
+        matches.emplace_back(q, bestIdx[q], (float)bestDist[q]);
+        if (second_distances != nullptr)
+        {
+            second_distances->push_back(secondDist[q] == INT_MAX ? std::numeric_limits<float>::infinity() : (float)secondDist[q]);
+        }
+    }
+}
+
+int HammingMatcher::Distance(const unsigned char *a, const unsigned char *b, const int num_bytes)
+{
+    int dist;
+    GetScanKernel()(a, b, 0, 1, num_bytes, &dist);
+    return dist;
+}
+
+int HammingMatcher::GetKernelLevel()
+{
+    static const int level = SelectKernelLevel();
+    return level;
+}
+
+}
+}
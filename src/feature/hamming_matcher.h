@@ -0,0 +1,29 @@
+#ifndef _HAMMING_MATCHER_H_
+#define _HAMMING_MATCHER_H_
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace omni_slam
+{
+namespace feature
+{
+
+class HammingMatcher
+{
+public:
+    HammingMatcher(const bool cross_check = true);
+
+    void Match(const cv::Mat &query, const cv::Mat &train, std::vector<cv::DMatch> &matches, std::vector<float> *second_distances = nullptr) const;
+
+    static int Distance(const unsigned char *a, const unsigned char *b, const int num_bytes);
+    static int GetKernelLevel();
+
+private:
+    const bool crossCheck_;
+};
+
+}
+}
+
+#endif /* _HAMMING_MATCHER_H_ */
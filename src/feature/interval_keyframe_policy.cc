@@ -0,0 +1,19 @@
+#include "interval_keyframe_policy.h"
+
+namespace omni_slam
+{
+namespace feature
+{
+
+IntervalKeyframePolicy::IntervalKeyframePolicy(const int interval)
+    : interval_(interval)
+{
+}
+
+bool IntervalKeyframePolicy::IsKeyframe(const std::vector<data::Landmark> &landmarks, const data::Frame &keyframe, const data::Frame &cur_frame, const int frames_since_keyframe) const
+{
+    return frames_since_keyframe >= interval_;
+}
+
+}
+}
@@ -0,0 +1,25 @@
+#ifndef _INTERVAL_KEYFRAME_POLICY_H_
+#define _INTERVAL_KEYFRAME_POLICY_H_
+
+#include "keyframe_policy.h"
+
+namespace omni_slam
+{
+namespace feature
+{
+
+class IntervalKeyframePolicy : public KeyframePolicy
+{
+public:
+    IntervalKeyframePolicy(const int interval = 1);
+
+    bool IsKeyframe(const std::vector<data::Landmark> &landmarks, const data::Frame &keyframe, const data::Frame &cur_frame, const int frames_since_keyframe) const;
+
+private:
+    const int interval_;
+};
+
+}
+}
+
+#endif /* _INTERVAL_KEYFRAME_POLICY_H_ */
@@ -0,0 +1,24 @@
+#ifndef _KEYFRAME_POLICY_H_
+#define _KEYFRAME_POLICY_H_
+
+#include <vector>
+#include "data/frame.h"
+#include "data/landmark.h"
+
+namespace omni_slam
+{
+namespace feature
+{
+
+class KeyframePolicy
+{
+public:
+    virtual ~KeyframePolicy() = default;
+
+    virtual bool IsKeyframe(const std::vector<data::Landmark> &landmarks, const data::Frame &keyframe, const data::Frame &cur_frame, const int frames_since_keyframe) const = 0;
+};
+
+}
+}
+
+#endif /* _KEYFRAME_POLICY_H_ */
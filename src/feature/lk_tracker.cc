@@ -1,5 +1,8 @@
 #include "lk_tracker.h"
 #include <cmath>
+#include <tuple>
+#include <algorithm>
+#include <chrono>
 #include "util/tf_util.h"
 #include <opencv2/optflow.hpp>
 
@@ -8,16 +11,251 @@ namespace omni_slam
 namespace feature
 {
 
-LKTracker::LKTracker(const int window_size, const int num_scales, const float delta_pix_err_thresh, const float err_thresh, const int keyframe_interval, const int term_count, const double term_eps)
+LKTracker::LKTracker(const int window_size, const int num_scales, const float delta_pix_err_thresh, const float err_thresh, const int keyframe_interval, const int term_count, const double term_eps, const int chunk_size, const bool native_kernel, const double fb_thresh, const bool spherical_remap, const bool benchmark_kernel)
     : Tracker(keyframe_interval),
     windowSize_(window_size / pow(2, num_scales), window_size / pow(2, num_scales)),
     numScales_(num_scales),
     errThresh_(err_thresh),
     deltaPixErrThresh_(delta_pix_err_thresh),
-    termCrit_(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, term_count, term_eps)
+    chunkSize_(chunk_size),
+    useNativeKernel_(native_kernel),
+    fbThresh_(fb_thresh),
+    useSphericalRemap_(spherical_remap),
+    benchmarkKernel_(benchmark_kernel),
+    termCrit_(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, term_count, term_eps),
+    sparseLK_(windowSize_, numScales_, termCrit_)
 {
 }
 
+void LKTracker::UpdateKeyframePyramids()
+{
+    if (keyframePyramidId_ == keyframeId_)
+    {
+        return;
+    }
+    if (prevPyramidId_ == keyframeId_)
+    {
+        keyframePyramid_ = prevPyramid_;
+        keyframeStereoPyramid_ = prevStereoPyramid_;
+    }
+    else
+    {
+        keyframeStereoPyramid_.clear();
+        BuildPyramid(keyframeImg_, remap_.get(), keyframePyramid_);
+    }
+    if (keyframeStereoPyramid_.empty() && !keyframeStereoImg_.empty())
+    {
+        BuildPyramid(keyframeStereoImg_, stereoRemap_.get(), keyframeStereoPyramid_);
+    }
+    keyframePyramidId_ = keyframeId_;
+}
+
+void LKTracker::UpdateKeyframeRawPyramids(bool stereo)
+{
+    if (stereo && keyframeRawStereoPyramidId_ != keyframeId_)
+    {
+        BuildPyramid(keyframeStereoImg_, nullptr, keyframeRawStereoPyramid_);
+        keyframeRawStereoPyramidId_ = keyframeId_;
+    }
+    else if (!stereo && keyframeRawPyramidId_ != keyframeId_)
+    {
+        BuildPyramid(keyframeImg_, nullptr, keyframeRawPyramid_);
+        keyframeRawPyramidId_ = keyframeId_;
+    }
+}
+
+void LKTracker::BuildPyramid(const cv::Mat &image, const camera::SphericalRemap *remap, std::vector<cv::Mat> &pyramid) const
+{
+    pyramid.clear();
+    if (remap != nullptr)
+    {
+        cv::Mat remapped;
+        remap->Remap(image, remapped);
+        cv::buildOpticalFlowPyramid(remapped, pyramid, windowSize_, numScales_, true);
+    }
+    else
+    {
+        cv::buildOpticalFlowPyramid(image, pyramid, windowSize_, numScales_, true);
+    }
+}
+
+void LKTracker::ToRemap(const camera::SphericalRemap &remap, std::vector<cv::Point2f> &points, std::vector<cv::Point2f> &results, std::vector<unsigned char> &valid) const
+{
+    valid.assign(points.size(), 1);
+    for (int i = 0; i < points.size(); i++)
+    {
+        if (!remap.ImageToRemap(points[i], points[i]))
+        {
+            valid[i] = 0;
+        }
+        if (!remap.ImageToRemap(results[i], results[i]))
+        {
+            results[i] = points[i];
+        }
+    }
+}
+
+void LKTracker::FromRemap(const camera::SphericalRemap &remap, std::vector<cv::Point2f> &results, std::vector<unsigned char> &status, const std::vector<unsigned char> &valid) const
+{
+    for (int i = 0; i < results.size(); i++)
+    {
+        if (!valid[i] || !remap.RemapToImage(results[i], results[i]))
+        {
+            status[i] = 0;
+        }
+    }
+}
+
+void LKTracker::TrackChunk(const std::vector<cv::Mat> &prev_pyramid, const std::vector<cv::Mat> &next_pyramid, const std::vector<cv::Point2f> &points, std::vector<cv::Point2f> &results, const std::vector<float> &window_scales, std::vector<unsigned char> &status, std::vector<float> &err, const int begin, const int end, const int flags) const
+{
+    std::vector<cv::Point2f> chunkPoints(points.begin() + begin, points.begin() + end);
+    std::vector<cv::Point2f> chunkResults(results.begin() + begin, results.begin() + end);
+    std::vector<unsigned char> chunkStatus;
+    std::vector<float> chunkErr;
+    if (useNativeKernel_)
+    {
+        std::vector<float> chunkScales(window_scales.begin() + begin, window_scales.begin() + end);
+        sparseLK_.Track(prev_pyramid, next_pyramid, chunkPoints, chunkResults, chunkScales, chunkStatus, chunkErr, flags & cv::OPTFLOW_USE_INITIAL_FLOW);
+    }
+    else
+    {
+        cv::calcOpticalFlowPyrLK(prev_pyramid, next_pyramid, chunkPoints, chunkResults, chunkStatus, chunkErr, windowSize_, numScales_, termCrit_, flags);
+    }
+    std::copy(chunkResults.begin(), chunkResults.end(), results.begin() + begin);
+    std::copy(chunkStatus.begin(), chunkStatus.end(), status.begin() + begin);
+    std::copy(chunkErr.begin(), chunkErr.end(), err.begin() + begin);
+}
+
+void LKTracker::TrackOutsideRemap(const std::vector<cv::Mat> &prev_pyramid, const std::vector<cv::Mat> &next_pyramid, const camera::CameraModel<> &camera_model, const double center_resolution, const std::vector<cv::KeyPoint> &orig_kpt, const std::vector<cv::Point2f> &init_results, const std::vector<unsigned char> &valid, std::vector<cv::Point2f> &results, std::vector<unsigned char> &status, std::vector<float> &err, const int flags)
+{
+    // Points the remap does not cover (the pole band of lenses wider than 180 degrees) are tracked on the raw image
+    std::vector<int> inx;
+    std::vector<cv::Point2f> points;
+    std::vector<cv::Point2f> rawResults;
+    std::vector<float> windowScales;
+    for (int i = 0; i < valid.size(); i++)
+    {
+        if (valid[i])
+        {
+            continue;
+        }
+        inx.push_back(i);
+        points.push_back(orig_kpt[i].pt);
+        rawResults.push_back(init_results[i]);
+        windowScales.push_back(useNativeKernel_ ? GetWindowScale(camera_model, orig_kpt[i].pt, center_resolution) : 1.f);
+    }
+    if (inx.empty())
+    {
+        return;
+    }
+    std::vector<unsigned char> rawStatus;
+    std::vector<float> rawErr;
+    std::vector<cv::Point2f> noPoints;
+    std::vector<float> noScales;
+    std::vector<unsigned char> noStatus;
+    std::vector<float> noErr;
+    TrackStreams(prev_pyramid, next_pyramid, points, rawResults, windowScales, rawStatus, rawErr, flags, nullptr, nullptr, noPoints, noPoints, noScales, noStatus, noErr, 0);
+    if (fbThresh_ > 0)
+    {
+        std::vector<cv::Point2f> backResults(rawResults);
+        std::vector<unsigned char> backStatus;
+        std::vector<float> backErr;
+        TrackStreams(next_pyramid, prev_pyramid, rawResults, backResults, windowScales, backStatus, backErr, 0, nullptr, nullptr, noPoints, noPoints, noScales, noStatus, noErr, 0);
+        for (int i = 0; i < inx.size(); i++)
+        {
+            if (rawStatus[i] == 1 && rawErr[i] <= errThresh_ && (backStatus[i] != 1 || cv::norm(backResults[i] - points[i]) > fbThresh_))
+            {
+                rawStatus[i] = 0;
+                numRejected_++;
+            }
+        }
+    }
+    for (int i = 0; i < inx.size(); i++)
+    {
+        results[inx[i]] = rawResults[i];
+        status[inx[i]] = rawStatus[i];
+        err[inx[i]] = rawErr[i];
+    }
+}
+
+void LKTracker::BenchmarkKernels(const std::vector<cv::Mat> &prev_pyramid, const std::vector<cv::Mat> &next_pyramid, const std::vector<cv::Point2f> &points, const std::vector<cv::Point2f> &results, const std::vector<float> &window_scales, const int flags)
+{
+    // Both kernels run single-threaded on the same points and initial flow, so timings are directly comparable
+    std::vector<cv::Point2f> nativeResults(results);
+    std::vector<unsigned char> nativeStatus;
+    std::vector<float> nativeErr;
+    auto nativeStart = std::chrono::steady_clock::now();
+    sparseLK_.Track(prev_pyramid, next_pyramid, points, nativeResults, window_scales, nativeStatus, nativeErr, flags & cv::OPTFLOW_USE_INITIAL_FLOW);
+    double nativeTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - nativeStart).count();
+
+    std::vector<cv::Point2f> cvResults(results);
+    std::vector<unsigned char> cvStatus;
+    std::vector<float> cvErr;
+    auto cvStart = std::chrono::steady_clock::now();
+    cv::calcOpticalFlowPyrLK(prev_pyramid, next_pyramid, points, cvResults, cvStatus, cvErr, windowSize_, numScales_, termCrit_, flags);
+    double cvTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - cvStart).count();
+
+    int numNative = 0;
+    int numCV = 0;
+    int numBoth = 0;
+    double endpointDiff = 0;
+    for (int i = 0; i < points.size(); i++)
+    {
+        numNative += nativeStatus[i];
+        numCV += cvStatus[i];
+        if (nativeStatus[i] == 1 && cvStatus[i] == 1)
+        {
+            endpointDiff += cv::norm(nativeResults[i] - cvResults[i]);
+            numBoth++;
+        }
+    }
+    kernelBenchmark_ = {(double)points.size(), nativeTime, cvTime, (double)numNative, (double)numCV, numBoth > 0 ? endpointDiff / numBoth : 0.};
+}
+
+float LKTracker::GetWindowScale(const camera::CameraModel<> &camera_model, const cv::Point2f &pt, const double center_resolution) const
+{
+    double resolution = camera_model.GetAngularResolution(Vector2d(pt.x, pt.y));
+    if (resolution <= 0 || center_resolution <= 0)
+    {
+        return 1.;
+    }
+    return center_resolution / resolution;
+}
+
+void LKTracker::TrackStreams(const std::vector<cv::Mat> &prev_pyramid, const std::vector<cv::Mat> &next_pyramid, const std::vector<cv::Point2f> &points, std::vector<cv::Point2f> &results, const std::vector<float> &window_scales, std::vector<unsigned char> &status, std::vector<float> &err, const int flags, const std::vector<cv::Mat> *stereo_prev_pyramid, const std::vector<cv::Mat> *stereo_next_pyramid, const std::vector<cv::Point2f> &stereo_points, std::vector<cv::Point2f> &stereo_results, const std::vector<float> &stereo_window_scales, std::vector<unsigned char> &stereo_status, std::vector<float> &stereo_err, const int stereo_flags) const
+{
+    status.assign(points.size(), 0);
+    err.assign(points.size(), 0.f);
+    stereo_status.assign(stereo_points.size(), 0);
+    stereo_err.assign(stereo_points.size(), 0.f);
+
+    std::vector<std::tuple<bool, int, int>> jobs;
+    int chunkSize = chunkSize_ > 0 ? chunkSize_ : std::max({points.size(), stereo_points.size(), (size_t)1});
+    for (int i = 0; i < points.size(); i += chunkSize)
+    {
+        jobs.emplace_back(false, i, std::min(i + chunkSize, (int)points.size()));
+    }
+    for (int i = 0; i < stereo_points.size(); i += chunkSize)
+    {
+        jobs.emplace_back(true, i, std::min(i + chunkSize, (int)stereo_points.size()));
+    }
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < jobs.size(); i++)
+    {
+        bool isStereo;
+        int begin, end;
+        std::tie(isStereo, begin, end) = jobs[i];
+        if (isStereo)
+        {
+            TrackChunk(*stereo_prev_pyramid, *stereo_next_pyramid, stereo_points, stereo_results, stereo_window_scales, stereo_status, stereo_err, begin, end, stereo_flags);
+        }
+        else
+        {
+            TrackChunk(prev_pyramid, next_pyramid, points, results, window_scales, status, err, begin, end, flags);
+        }
+    }
+}
+
 int LKTracker::DoTrack(std::vector<data::Landmark> &landmarks, data::Frame &cur_frame, std::vector<double> &errors, bool stereo)
 {
     std::vector<cv::Point2f> pointsToTrack;
@@ -28,15 +266,39 @@ int LKTracker::DoTrack(std::vector<data::Landmark> &landmarks, data::Frame &cur_
     std::vector<int> stereoOrigInx;
     std::vector<cv::Point2f> results;
     std::vector<cv::Point2f> stereoResults;
+    std::vector<float> windowScales;
+    std::vector<float> stereoWindowScales;
+    double centerResolution = 0;
+    double stereoCenterResolution = 0;
+    if (useNativeKernel_ || benchmarkKernel_)
+    {
+        Vector2d center(keyframeImg_.cols / 2., keyframeImg_.rows / 2.);
+        centerResolution = keyframe_->GetCameraModel().GetAngularResolution(center);
+        if (keyframe_->HasStereoImage())
+        {
+            stereoCenterResolution = keyframe_->GetStereoCameraModel().GetAngularResolution(center);
+        }
+    }
+    bool usePrediction = false;
     for (int i = 0; i < landmarks.size(); i++)
     {
         data::Landmark &landmark = landmarks[i];
+        if (landmark.IsTerminated())
+        {
+            continue;
+        }
         const data::Feature *feat = landmark.GetObservationByFrameID(keyframeId_);
         const data::Feature *featPrev = landmark.GetObservationByFrameID(prevId_);
         if (feat != nullptr)
         {
             pointsToTrack.push_back(feat->GetKeypoint().pt);
-            if (featPrev != nullptr)
+            Vector2d pixelPred;
+            if (cur_frame.HasPredictedPose() && landmark.HasEstimatedPosition() && cur_frame.GetCameraModel().ProjectToImage(util::TFUtil::WorldFrameToCameraFrame(util::TFUtil::TransformPoint(cur_frame.GetPredictedInversePose(), landmark.GetEstimatedPosition())), pixelPred))
+            {
+                results.push_back(cv::Point2f(pixelPred(0), pixelPred(1)));
+                usePrediction = true;
+            }
+            else if (featPrev != nullptr)
             {
                 results.push_back(featPrev->GetKeypoint().pt);
             }
@@ -46,6 +308,10 @@ int LKTracker::DoTrack(std::vector<data::Landmark> &landmarks, data::Frame &cur_
             }
             origKpt.push_back(feat->GetKeypoint());
             origInx.push_back(i);
+            if (useNativeKernel_ || benchmarkKernel_)
+            {
+                windowScales.push_back(useSphericalRemap_ ? 1.f : GetWindowScale(keyframe_->GetCameraModel(), feat->GetKeypoint().pt, centerResolution));
+            }
         }
         if (!stereo)
         {
@@ -68,6 +334,10 @@ int LKTracker::DoTrack(std::vector<data::Landmark> &landmarks, data::Frame &cur_
                 }
                 stereoOrigKpt.push_back(stereoFeat->GetKeypoint());
                 stereoOrigInx.push_back(i);
+                if (useNativeKernel_)
+                {
+                    stereoWindowScales.push_back(useSphericalRemap_ ? 1.f : GetWindowScale(keyframe_->GetStereoCameraModel(), stereoFeat->GetKeypoint().pt, stereoCenterResolution));
+                }
             }
         }
     }
@@ -75,10 +345,55 @@ int LKTracker::DoTrack(std::vector<data::Landmark> &landmarks, data::Frame &cur_
     {
         return 0;
     }
+    std::vector<unsigned char> remapValid;
+    std::vector<unsigned char> stereoRemapValid;
+    std::vector<cv::Point2f> initResults;
+    std::vector<cv::Point2f> stereoInitResults;
+    std::vector<cv::Mat> remapPyramid;
+    std::vector<cv::Mat> remapStereoPyramid;
+    const std::vector<cv::Mat> *curPyramid = nullptr;
+    const std::vector<cv::Mat> *curStereoPyramid = nullptr;
+    if (useSphericalRemap_)
+    {
+        if (!remap_)
+        {
+            remap_.reset(new camera::SphericalRemap(cur_frame.GetCameraModel(), keyframeImg_.size()));
+        }
+        if (!stereoRemap_ && cur_frame.HasStereoImage() && !keyframeStereoImg_.empty())
+        {
+            stereoRemap_.reset(new camera::SphericalRemap(cur_frame.GetStereoCameraModel(), keyframeStereoImg_.size()));
+        }
+        initResults = results;
+        ToRemap(*remap_, pointsToTrack, results, remapValid);
+        BuildPyramid(cur_frame.GetImage(), remap_.get(), remapPyramid);
+        curPyramid = &remapPyramid;
+        if (stereoPointsToTrack.size() > 0)
+        {
+            stereoInitResults = stereoResults;
+            ToRemap(*stereoRemap_, stereoPointsToTrack, stereoResults, stereoRemapValid);
+            BuildPyramid(cur_frame.GetStereoImage(), stereoRemap_.get(), remapStereoPyramid);
+            curStereoPyramid = &remapStereoPyramid;
+        }
+    }
+    else
+    {
+        curPyramid = &cur_frame.GetPyramid(windowSize_, numScales_);
+        if (stereoPointsToTrack.size() > 0)
+        {
+            curStereoPyramid = &cur_frame.GetStereoPyramid(windowSize_, numScales_);
+        }
+    }
+    UpdateKeyframePyramids();
+    int flags = (prevId_ == keyframeId_ && !usePrediction) ? 0 : cv::OPTFLOW_USE_INITIAL_FLOW;
+    int stereoFlags = prevId_ == keyframeId_ ? 0 : cv::OPTFLOW_USE_INITIAL_FLOW;
     std::vector<unsigned char> status;
     std::vector<float> err;
     std::vector<unsigned char> stereoStatus;
     std::vector<float> stereoErr;
+    if (benchmarkKernel_)
+    {
+        BenchmarkKernels(keyframePyramid_, *curPyramid, pointsToTrack, results, windowScales, flags);
+    }
     //cv::Mat keyframeColor;
     //cv::Mat curColor;
     //cv::cvtColor(keyframeImg_, keyframeColor, cv::COLOR_GRAY2BGR);
@@ -89,34 +404,107 @@ int LKTracker::DoTrack(std::vector<data::Landmark> &landmarks, data::Frame &cur_
     //params->setMaxLevel(numScales_);
     //params->setUseGlobalMotionPrior(false);
     //params->setMaxIteration(termCrit_.maxCount);
-    if (prevId_ == keyframeId_)
+    //params->setUseInitialFlow(flags & cv::OPTFLOW_USE_INITIAL_FLOW);
+    //cv::optflow::calcOpticalFlowSparseRLOF(keyframeColor, curColor, pointsToTrack, results, status, err, params, errThresh_);
+    //cv::Mat keyframeStereoColor;
+    //cv::Mat curStereoColor;
+    //cv::cvtColor(keyframeStereoImg_, keyframeStereoColor, cv::COLOR_GRAY2BGR);
+    //cv::cvtColor(cur_frame.GetStereoImage(), curStereoColor, cv::COLOR_GRAY2BGR);
+    //params->setUseInitialFlow(stereoFlags & cv::OPTFLOW_USE_INITIAL_FLOW);
+    //cv::optflow::calcOpticalFlowSparseRLOF(keyframeStereoColor, curStereoColor, stereoPointsToTrack, stereoResults, stereoStatus, stereoErr, params, errThresh_);
+    TrackStreams(keyframePyramid_, *curPyramid, pointsToTrack, results, windowScales, status, err, flags, &keyframeStereoPyramid_, curStereoPyramid, stereoPointsToTrack, stereoResults, stereoWindowScales, stereoStatus, stereoErr, stereoFlags);
+
+    if (fbThresh_ > 0)
     {
-        cv::calcOpticalFlowPyrLK(keyframeImg_, cur_frame.GetImage(), pointsToTrack, results, status, err, windowSize_, numScales_, termCrit_, 0);
-        //cv::optflow::calcOpticalFlowSparseRLOF(keyframeColor, curColor, pointsToTrack, results, status, err, params, errThresh_);
+        std::vector<int> fwdInx;
+        std::vector<cv::Point2f> backPoints;
+        std::vector<cv::Point2f> backResults;
+        std::vector<float> backWindowScales;
+        std::vector<int> stereoFwdInx;
+        std::vector<cv::Point2f> stereoBackPoints;
+        std::vector<cv::Point2f> stereoBackResults;
+        std::vector<float> stereoBackWindowScales;
+        for (int i = 0; i < results.size(); i++)
+        {
+            if (status[i] == 1 && err[i] <= errThresh_)
+            {
+                fwdInx.push_back(i);
+                backPoints.push_back(results[i]);
+                backResults.push_back(results[i]);
+                if (useNativeKernel_)
+                {
+                    backWindowScales.push_back(windowScales[i]);
+                }
+            }
+        }
+        for (int i = 0; i < stereoResults.size(); i++)
+        {
+            if (stereoStatus[i] == 1 && stereoErr[i] <= errThresh_)
+            {
+                stereoFwdInx.push_back(i);
+                stereoBackPoints.push_back(stereoResults[i]);
+                stereoBackResults.push_back(stereoResults[i]);
+                if (useNativeKernel_)
+                {
+                    stereoBackWindowScales.push_back(stereoWindowScales[i]);
+                }
+            }
+        }
+        std::vector<unsigned char> backStatus;
+        std::vector<float> backErr;
+        std::vector<unsigned char> stereoBackStatus;
+        std::vector<float> stereoBackErr;
+        // The backward pass starts from the forward result, seeding it with the original point would bias it toward passing
+        TrackStreams(*curPyramid, keyframePyramid_, backPoints, backResults, backWindowScales, backStatus, backErr, 0, curStereoPyramid, &keyframeStereoPyramid_, stereoBackPoints, stereoBackResults, stereoBackWindowScales, stereoBackStatus, stereoBackErr, 0);
+        for (int i = 0; i < fwdInx.size(); i++)
+        {
+            if (backStatus[i] != 1 || cv::norm(backResults[i] - pointsToTrack[fwdInx[i]]) > fbThresh_)
+            {
+                status[fwdInx[i]] = 0;
+                numRejected_++;
+            }
+        }
+        for (int i = 0; i < stereoFwdInx.size(); i++)
+        {
+            if (stereoBackStatus[i] != 1 || cv::norm(stereoBackResults[i] - stereoPointsToTrack[stereoFwdInx[i]]) > fbThresh_)
+            {
+                stereoStatus[stereoFwdInx[i]] = 0;
+                numRejected_++;
+            }
+        }
     }
-    else
+
+    prevPyramid_ = *curPyramid;
+    prevStereoPyramid_.clear();
+    if (curStereoPyramid != nullptr)
     {
-        cv::calcOpticalFlowPyrLK(keyframeImg_, cur_frame.GetImage(), pointsToTrack, results, status, err, windowSize_, numScales_, termCrit_, cv::OPTFLOW_USE_INITIAL_FLOW);
-        //params->setUseInitialFlow(true);
-        //cv::optflow::calcOpticalFlowSparseRLOF(keyframeColor, curColor, pointsToTrack, results, status, err, params, errThresh_);
+        prevStereoPyramid_ = *curStereoPyramid;
     }
-    if (stereoPointsToTrack.size() > 0)
+    prevPyramidId_ = cur_frame.GetID();
+
+    if (useSphericalRemap_)
     {
-        //cv::Mat keyframeStereoColor;
-        //cv::Mat curStereoColor;
-        //cv::cvtColor(keyframeStereoImg_, keyframeStereoColor, cv::COLOR_GRAY2BGR);
-        //cv::cvtColor(cur_frame.GetStereoImage(), curStereoColor, cv::COLOR_GRAY2BGR);
-        if (prevId_ == keyframeId_)
+        FromRemap(*remap_, results, status, remapValid);
+        for (int i = 0; i < pointsToTrack.size(); i++)
         {
-            cv::calcOpticalFlowPyrLK(keyframeStereoImg_, cur_frame.GetStereoImage(), stereoPointsToTrack, stereoResults, stereoStatus, stereoErr, windowSize_, numScales_, termCrit_, 0);
-            //cv::optflow::calcOpticalFlowSparseRLOF(keyframeStereoColor, curStereoColor, stereoPointsToTrack, stereoResults, stereoStatus, stereoErr, params, errThresh_);
+            pointsToTrack[i] = origKpt[i].pt;
         }
-        else
+        if (std::find(remapValid.begin(), remapValid.end(), 0) != remapValid.end())
         {
-            cv::calcOpticalFlowPyrLK(keyframeStereoImg_, cur_frame.GetStereoImage(), stereoPointsToTrack, stereoResults, stereoStatus, stereoErr, windowSize_, numScales_, termCrit_, cv::OPTFLOW_USE_INITIAL_FLOW);
-            //cv::optflow::calcOpticalFlowSparseRLOF(keyframeStereoColor, curStereoColor, stereoPointsToTrack, stereoResults, stereoStatus, stereoErr, params, errThresh_);
+            UpdateKeyframeRawPyramids(false);
+            TrackOutsideRemap(keyframeRawPyramid_, cur_frame.GetPyramid(windowSize_, numScales_), keyframe_->GetCameraModel(), centerResolution, origKpt, initResults, remapValid, results, status, err, flags);
+        }
+        if (stereoPointsToTrack.size() > 0)
+        {
+            FromRemap(*stereoRemap_, stereoResults, stereoStatus, stereoRemapValid);
+            if (std::find(stereoRemapValid.begin(), stereoRemapValid.end(), 0) != stereoRemapValid.end())
+            {
+                UpdateKeyframeRawPyramids(true);
+                TrackOutsideRemap(keyframeRawStereoPyramid_, cur_frame.GetStereoPyramid(windowSize_, numScales_), keyframe_->GetStereoCameraModel(), stereoCenterResolution, stereoOrigKpt, stereoInitResults, stereoRemapValid, stereoResults, stereoStatus, stereoErr, stereoFlags);
+            }
         }
     }
+
     errors.clear();
     int numGood = 0;
     for (int i = 0; i < results.size(); i++)
@@ -2,11 +2,14 @@
 #define _LK_TRACKER_H_
 
 #include "tracker.h"
+#include "sparse_lk.h"
+#include "camera/spherical_remap.h"
 #include <opencv2/opencv.hpp>
 #include "data/frame.h"
 #include "data/landmark.h"
 #include "odometry/five_point.h"
 #include <vector>
+#include <memory>
 
 namespace omni_slam
 {
@@ -16,16 +19,46 @@ namespace feature
 class LKTracker : public Tracker
 {
 public:
-    LKTracker(const int window_size, const int num_scales, const float delta_pix_err_thresh = 5., const float err_thresh = 20., const int keyframe_interval = 1, const int term_count = 50, const double term_eps = 0.01);
+    LKTracker(const int window_size, const int num_scales, const float delta_pix_err_thresh = 5., const float err_thresh = 20., const int keyframe_interval = 1, const int term_count = 50, const double term_eps = 0.01, const int chunk_size = 256, const bool native_kernel = false, const double fb_thresh = 0., const bool spherical_remap = false, const bool benchmark_kernel = false);
 
 private:
     int DoTrack(std::vector<data::Landmark> &landmarks, data::Frame &cur_frame, std::vector<double> &errors, bool stereo);
+    void UpdateKeyframePyramids();
+    void UpdateKeyframeRawPyramids(bool stereo);
+    void BuildPyramid(const cv::Mat &image, const camera::SphericalRemap *remap, std::vector<cv::Mat> &pyramid) const;
+    void ToRemap(const camera::SphericalRemap &remap, std::vector<cv::Point2f> &points, std::vector<cv::Point2f> &results, std::vector<unsigned char> &valid) const;
+    void FromRemap(const camera::SphericalRemap &remap, std::vector<cv::Point2f> &results, std::vector<unsigned char> &status, const std::vector<unsigned char> &valid) const;
+    void TrackChunk(const std::vector<cv::Mat> &prev_pyramid, const std::vector<cv::Mat> &next_pyramid, const std::vector<cv::Point2f> &points, std::vector<cv::Point2f> &results, const std::vector<float> &window_scales, std::vector<unsigned char> &status, std::vector<float> &err, const int begin, const int end, const int flags) const;
+    void TrackStreams(const std::vector<cv::Mat> &prev_pyramid, const std::vector<cv::Mat> &next_pyramid, const std::vector<cv::Point2f> &points, std::vector<cv::Point2f> &results, const std::vector<float> &window_scales, std::vector<unsigned char> &status, std::vector<float> &err, const int flags, const std::vector<cv::Mat> *stereo_prev_pyramid, const std::vector<cv::Mat> *stereo_next_pyramid, const std::vector<cv::Point2f> &stereo_points, std::vector<cv::Point2f> &stereo_results, const std::vector<float> &stereo_window_scales, std::vector<unsigned char> &stereo_status, std::vector<float> &stereo_err, const int stereo_flags) const;
+    void TrackOutsideRemap(const std::vector<cv::Mat> &prev_pyramid, const std::vector<cv::Mat> &next_pyramid, const camera::CameraModel<> &camera_model, const double center_resolution, const std::vector<cv::KeyPoint> &orig_kpt, const std::vector<cv::Point2f> &init_results, const std::vector<unsigned char> &valid, std::vector<cv::Point2f> &results, std::vector<unsigned char> &status, std::vector<float> &err, const int flags);
+    void BenchmarkKernels(const std::vector<cv::Mat> &prev_pyramid, const std::vector<cv::Mat> &next_pyramid, const std::vector<cv::Point2f> &points, const std::vector<cv::Point2f> &results, const std::vector<float> &window_scales, const int flags);
+    float GetWindowScale(const camera::CameraModel<> &camera_model, const cv::Point2f &pt, const double center_resolution) const;
 
     cv::TermCriteria termCrit_;
     const cv::Size windowSize_;
     const int numScales_;
     const float errThresh_;
     const float deltaPixErrThresh_;
+    const int chunkSize_;
+    const bool useNativeKernel_;
+    const double fbThresh_;
+    const bool useSphericalRemap_;
+    const bool benchmarkKernel_;
+    const SparseLK sparseLK_;
+
+    std::vector<cv::Mat> keyframePyramid_;
+    std::vector<cv::Mat> keyframeStereoPyramid_;
+    std::vector<cv::Mat> prevPyramid_;
+    std::vector<cv::Mat> prevStereoPyramid_;
+    int keyframePyramidId_{-1};
+    std::vector<cv::Mat> keyframeRawPyramid_;
+    std::vector<cv::Mat> keyframeRawStereoPyramid_;
+    int keyframeRawPyramidId_{-1};
+    int keyframeRawStereoPyramidId_{-1};
+    int prevPyramidId_{-1};
+
+    std::shared_ptr<camera::SphericalRemap> remap_;
+    std::shared_ptr<camera::SphericalRemap> stereoRemap_;
 };
 
 }
@@ -1,37 +1,67 @@
 #include "matcher.h"
 
+#include <cmath>
+#include <limits>
+#include <set>
+
 namespace omni_slam
 {
 namespace feature
 {
 
-Matcher::Matcher(std::string descriptor_type, double max_dist)
-    : maxDistance_(max_dist)
+Matcher::Matcher(std::string descriptor_type, double max_dist, bool approximate, bool ratio_test, double max_ratio)
+    : maxDistance_(max_dist),
+    hammingMatcher_(!ratio_test),
+    approximate_(approximate),
+    ratioTest_(ratio_test),
+    maxRatio_(max_ratio)
 {
     if (descriptor_type == "SIFT" || descriptor_type == "SURF" || descriptor_type == "KAZE" || descriptor_type == "DAISY" || descriptor_type == "VGG")
     {
-        matcher_ = cv::BFMatcher::create(cv::NORM_L2, true);
+        matcher_ = cv::BFMatcher::create(cv::NORM_L2, !ratio_test);
+        bestMatcher_ = cv::BFMatcher::create(cv::NORM_L2, false);
     }
     else if (descriptor_type == "ORB" || descriptor_type == "BRISK" || descriptor_type == "AKAZE" || descriptor_type == "FREAK" || descriptor_type == "LATCH" || descriptor_type == "LUCID" || descriptor_type == "BOOST")
     {
-        matcher_ = cv::BFMatcher::create(cv::NORM_HAMMING, true);
+        matcher_ = cv::BFMatcher::create(cv::NORM_HAMMING, !ratio_test);
+        bestMatcher_ = cv::BFMatcher::create(cv::NORM_HAMMING, false);
+        binary_ = true;
     }
 }
 
 std::map<std::pair<int, int>, int> Matcher::Match(const std::vector<data::Landmark> &train, const std::vector<data::Landmark> &query, std::vector<data::Landmark> &matches, std::vector<std::vector<double>> &distances, std::vector<int> &query_match_indices, bool stereo) const
 {
-    std::map<int, cv::Mat> trainDescriptors;
+    std::vector<std::vector<double>> secondDistances;
+    return Match(train, query, matches, distances, secondDistances, query_match_indices, stereo);
+}
+
+std::map<std::pair<int, int>, int> Matcher::Match(const std::vector<data::Landmark> &train, const std::vector<data::Landmark> &query, std::vector<data::Landmark> &matches, std::vector<std::vector<double>> &distances, std::vector<std::vector<double>> &second_distances, std::vector<int> &query_match_indices, bool stereo) const
+{
     std::map<int, std::vector<const data::Feature*>> trainDescInxToFeature;
+    std::map<int, std::vector<int>> trainLandmarkIds;
     for (const data::Landmark &landmark : train)
     {
         for (const data::Feature &feat : stereo ? landmark.GetStereoObservations() : landmark.GetObservations())
         {
-            const int id = feat.GetFrame().GetID();
-            trainDescInxToFeature[id].push_back(&feat);
-            trainDescriptors[id].push_back(feat.GetDescriptor());
+            trainDescInxToFeature[feat.GetFrame().GetID()].push_back(&feat);
+            trainLandmarkIds[feat.GetFrame().GetID()].push_back(landmark.GetID());
+        }
+    }
+    std::map<int, cv::Mat> trainDescriptors;
+    std::set<int> cachedTrainFrames;
+    for (auto &trainPair : trainDescInxToFeature)
+    {
+        auto indexIt = indices_.find({trainPair.first, stereo});
+        if (indexIt != indices_.end() && IsSameTrainSet(indexIt->second, trainPair.second, trainLandmarkIds.at(trainPair.first)))
+        {
+            cachedTrainFrames.insert(trainPair.first);
+            trainDescriptors[trainPair.first] = indexIt->second.descriptors;
+        }
+        else
+        {
+            trainDescriptors[trainPair.first] = StackDescriptors(trainPair.second);
         }
     }
-    std::map<int, cv::Mat> queryDescriptors;
     std::map<int, std::vector<const data::Feature*>> queryDescInxToFeature;
     std::map<const data::Feature*, int> featureToQueryInx;
     int i = 0;
@@ -39,54 +69,375 @@ std::map<std::pair<int, int>, int> Matcher::Match(const std::vector<data::Landma
     {
         for (const data::Feature &feat : stereo ? landmark.GetStereoObservations() : landmark.GetObservations())
         {
-            const int id = feat.GetFrame().GetID();
-            queryDescInxToFeature[id].push_back(&feat);
-            queryDescriptors[id].push_back(feat.GetDescriptor());
+            queryDescInxToFeature[feat.GetFrame().GetID()].push_back(&feat);
             featureToQueryInx[&feat] = i;
         }
         i++;
     }
+    std::map<int, cv::Mat> queryDescriptors;
+    for (auto &queryPair : queryDescInxToFeature)
+    {
+        queryDescriptors[queryPair.first] = StackDescriptors(queryPair.second);
+    }
 
     std::map<std::pair<int, int>, int> numMatches;
     matches.clear();
     distances.clear();
+    second_distances.clear();
     query_match_indices.clear();
     std::map<const data::Feature*, int> featureToMatchesInx;
+    std::vector<std::pair<int, int>> framePairs;
     for (auto &queryPair : queryDescriptors)
     {
         for (auto &trainPair : trainDescriptors)
         {
             if (trainPair.first != queryPair.first)
             {
-                std::vector<cv::DMatch> dmatches;
-                matcher_->match(queryPair.second, trainPair.second, dmatches);
-                int numGood = 0;
-                for (cv::DMatch &match : dmatches)
+                framePairs.emplace_back(queryPair.first, trainPair.first);
+            }
+        }
+    }
+
+    // Indices are built up front so that the parallel searches below only read them
+    std::map<int, TrainIndex> queryIndices;
+    std::map<int, const TrainIndex*> trainIndices;
+    std::map<int, TrainIndex> tempTrainIndices;
+    if (approximate_)
+    {
+        for (auto &framePair : framePairs)
+        {
+            if (queryIndices.find(framePair.first) == queryIndices.end())
+            {
+                TrainIndex &entry = queryIndices[framePair.first];
+                entry.indexDescriptors = GetIndexDescriptors(queryDescriptors.at(framePair.first));
+                entry.index = BuildIndex(entry.indexDescriptors);
+            }
+            if (trainIndices.find(framePair.second) != trainIndices.end())
+            {
+                continue;
+            }
+            auto indexIt = indices_.find({framePair.second, stereo});
+            if (indexIt != indices_.end() && !indexIt->second.index.empty() && cachedTrainFrames.find(framePair.second) != cachedTrainFrames.end())
+            {
+                trainIndices[framePair.second] = &indexIt->second;
+            }
+            else
+            {
+                TrainIndex &entry = tempTrainIndices[framePair.second];
+                entry.indexDescriptors = GetIndexDescriptors(trainDescriptors.at(framePair.second));
+                entry.index = BuildIndex(entry.indexDescriptors);
+                trainIndices[framePair.second] = &entry;
+            }
+        }
+    }
+
+    std::vector<std::vector<cv::DMatch>> pairMatches(framePairs.size());
+    std::vector<std::vector<float>> pairSecondDistances(framePairs.size());
+    // A single pair is left to the matcher so that its own row-parallel loop is not serialized
+    #pragma omp parallel for schedule(dynamic) if (framePairs.size() > 1)
+    for (int p = 0; p < framePairs.size(); p++)
+    {
+        const cv::Mat &queryDesc = queryDescriptors.at(framePairs[p].first);
+        const cv::Mat &trainDesc = trainDescriptors.at(framePairs[p].second);
+        if (approximate_)
+        {
+            const TrainIndex &queryIndex = queryIndices.at(framePairs[p].first);
+            const TrainIndex &trainIndex = *trainIndices.at(framePairs[p].second);
+            MatchApproximate(queryIndex.indexDescriptors, *queryIndex.index, trainIndex.indexDescriptors, *trainIndex.index, pairMatches[p], pairSecondDistances[p]);
+        }
+        else if (binary_ && queryDesc.type() == CV_8U && trainDesc.type() == CV_8U)
+        {
+            hammingMatcher_.Match(queryDesc, trainDesc, pairMatches[p], &pairSecondDistances[p]);
+        }
+        else
+        {
+            MatchExhaustive(queryDesc, trainDesc, pairMatches[p], pairSecondDistances[p]);
+        }
+    }
+
+    for (int p = 0; p < framePairs.size(); p++)
+    {
+        const int queryId = framePairs[p].first;
+        const int trainId = framePairs[p].second;
+        int numGood = 0;
+        for (int m = 0; m < pairMatches[p].size(); m++)
+        {
+            const cv::DMatch &match = pairMatches[p][m];
+            double dist = match.distance;
+            if (maxDistance_ > 0 && dist > maxDistance_)
+            {
+                continue;
+            }
+            double secondDist = m < pairSecondDistances[p].size() ? pairSecondDistances[p][m] : std::numeric_limits<double>::infinity();
+            if (ratioTest_ && maxRatio_ > 0 && (secondDist <= 0 || dist / secondDist > maxRatio_))
+            {
+                continue;
+            }
+            const data::Feature *queryFeat = queryDescInxToFeature[queryId][match.queryIdx];
+            if (featureToMatchesInx.find(queryFeat) == featureToMatchesInx.end())
+            {
+                featureToMatchesInx[queryFeat] = matches.size();
+                data::Landmark landmark;
+                landmark.AddObservation(*queryFeat, false);
+                matches.push_back(landmark);
+                distances.push_back(std::vector<double>());
+                second_distances.push_back(std::vector<double>());
+                query_match_indices.push_back(featureToQueryInx[queryFeat]);
+            }
+            matches[featureToMatchesInx[queryFeat]].AddObservation(*trainDescInxToFeature[trainId][match.trainIdx]);
+            distances[featureToMatchesInx[queryFeat]].push_back(fabs(match.distance));
+            second_distances[featureToMatchesInx[queryFeat]].push_back(secondDist);
+            numGood++;
+        }
+        numMatches[{trainId, queryId}] = numGood;
+    }
+    return numMatches;
+}
+
+void Matcher::MatchExhaustive(const cv::Mat &query, const cv::Mat &train, std::vector<cv::DMatch> &matches, std::vector<float> &second_distances) const
+{
+    if (query.empty() || train.empty())
+    {
+        return;
+    }
+    // Rows are matched in blocks so that a single frame pair still uses every thread, nested calls run serially
+    const int numQueryBlocks = (query.rows + exhaustiveBlockSize_ - 1) / exhaustiveBlockSize_;
+    if (ratioTest_)
+    {
+        std::vector<std::vector<std::vector<cv::DMatch>>> blockMatches(numQueryBlocks);
+        #pragma omp parallel for schedule(dynamic)
+        for (int b = 0; b < numQueryBlocks; b++)
+        {
+            matcher_->knnMatch(query.rowRange(b * exhaustiveBlockSize_, std::min((b + 1) * exhaustiveBlockSize_, query.rows)), train, blockMatches[b], 2);
+        }
+        for (int b = 0; b < numQueryBlocks; b++)
+        {
+            for (std::vector<cv::DMatch> &knn : blockMatches[b])
+            {
+                if (knn.empty())
                 {
-                    double dist = match.distance;
-                    if (maxDistance_ > 0 && dist > maxDistance_)
-                    {
-                        continue;
-                    }
-                    const data::Feature *queryFeat = queryDescInxToFeature[queryPair.first][match.queryIdx];
-                    if (featureToMatchesInx.find(queryFeat) == featureToMatchesInx.end())
-                    {
-                        featureToMatchesInx[queryFeat] = matches.size();
-                        data::Landmark landmark;
-                        landmark.AddObservation(*queryFeat, false);
-                        matches.push_back(landmark);
-                        distances.push_back(std::vector<double>());
-                        query_match_indices.push_back(featureToQueryInx[queryFeat]);
-                    }
-                    matches[featureToMatchesInx[queryFeat]].AddObservation(*trainDescInxToFeature[trainPair.first][match.trainIdx]);
-                    distances[featureToMatchesInx[queryFeat]].push_back(fabs(match.distance));
-                    numGood++;
+                    continue;
                 }
-                numMatches[{trainPair.first, queryPair.first}] = numGood;
+                knn[0].queryIdx += b * exhaustiveBlockSize_;
+                matches.push_back(knn[0]);
+                second_distances.push_back(knn.size() > 1 ? knn[1].distance : std::numeric_limits<float>::infinity());
             }
         }
+        return;
+    }
+
+    // Cross-checking needs every query row, so both directions are matched blockwise and intersected
+    const int numTrainBlocks = (train.rows + exhaustiveBlockSize_ - 1) / exhaustiveBlockSize_;
+    std::vector<std::vector<cv::DMatch>> forward(numQueryBlocks);
+    std::vector<std::vector<cv::DMatch>> backward(numTrainBlocks);
+    #pragma omp parallel for schedule(dynamic)
+    for (int b = 0; b < numQueryBlocks + numTrainBlocks; b++)
+    {
+        if (b < numQueryBlocks)
+        {
+            bestMatcher_->match(query.rowRange(b * exhaustiveBlockSize_, std::min((b + 1) * exhaustiveBlockSize_, query.rows)), train, forward[b]);
+        }
+        else
+        {
+            int t = b - numQueryBlocks;
+            bestMatcher_->match(train.rowRange(t * exhaustiveBlockSize_, std::min((t + 1) * exhaustiveBlockSize_, train.rows)), query, backward[t]);
+        }
+    }
+    std::vector<int> bestQuery(train.rows, -1);
+    for (int t = 0; t < numTrainBlocks; t++)
+    {
+        for (const cv::DMatch &match : backward[t])
+        {
+            bestQuery[match.queryIdx + t * exhaustiveBlockSize_] = match.trainIdx;
+        }
+    }
+    for (int b = 0; b < numQueryBlocks; b++)
+    {
+        for (cv::DMatch match : forward[b])
+        {
+            match.queryIdx += b * exhaustiveBlockSize_;
+            if (bestQuery[match.trainIdx] == match.queryIdx)
+            {
+                matches.push_back(match);
+            }
+        }
+    }
+}
+
+void Matcher::Index(const std::vector<data::Landmark> &train, bool stereo)
+{
+    std::map<int, std::vector<const data::Feature*>> trainFeatures;
+    std::map<int, std::vector<int>> trainLandmarkIds;
+    for (const data::Landmark &landmark : train)
+    {
+        for (const data::Feature &feat : stereo ? landmark.GetStereoObservations() : landmark.GetObservations())
+        {
+            trainFeatures[feat.GetFrame().GetID()].push_back(&feat);
+            trainLandmarkIds[feat.GetFrame().GetID()].push_back(landmark.GetID());
+        }
+    }
+    for (auto &trainPair : trainFeatures)
+    {
+        auto indexIt = indices_.find({trainPair.first, stereo});
+        if (indexIt != indices_.end() && IsSameTrainSet(indexIt->second, trainPair.second, trainLandmarkIds.at(trainPair.first)))
+        {
+            continue;
+        }
+        TrainIndex &entry = indices_[{trainPair.first, stereo}];
+        entry = TrainIndex();
+        entry.descriptors = StackDescriptors(trainPair.second);
+        SetTrainIdentity(entry, trainPair.second, trainLandmarkIds.at(trainPair.first));
+        if (approximate_)
+        {
+            entry.indexDescriptors = GetIndexDescriptors(entry.descriptors);
+            entry.index = BuildIndex(entry.indexDescriptors);
+        }
+    }
+}
+
+bool Matcher::IsRatioTest() const
+{
+    return ratioTest_;
+}
+
+bool Matcher::IsApproximate() const
+{
+    return approximate_;
+}
+
+void Matcher::SetApproximate(bool approximate)
+{
+    approximate_ = approximate;
+    if (!approximate_)
+    {
+        return;
+    }
+    for (auto &indexPair : indices_)
+    {
+        if (indexPair.second.index.empty())
+        {
+            indexPair.second.indexDescriptors = GetIndexDescriptors(indexPair.second.descriptors);
+            indexPair.second.index = BuildIndex(indexPair.second.indexDescriptors);
+        }
+    }
+}
+
+double Matcher::DescriptorDistance(const cv::Mat &desc1, const cv::Mat &desc2) const
+{
+    if (binary_ && desc1.type() == CV_8U && desc2.type() == CV_8U)
+    {
+        return HammingMatcher::Distance(desc1.ptr<unsigned char>(), desc2.ptr<unsigned char>(), desc1.cols);
+    }
+    return cv::norm(desc1, desc2, cv::NORM_L2);
+}
+
+void Matcher::SetTrainIdentity(TrainIndex &entry, const std::vector<const data::Feature*> &features, const std::vector<int> &landmark_ids)
+{
+    entry.firstLandmarkId = landmark_ids.front();
+    entry.lastLandmarkId = landmark_ids.back();
+    entry.firstDescriptorIndex = features.front()->GetDescriptorIndex();
+    entry.lastDescriptorIndex = features.back()->GetDescriptorIndex();
+}
+
+bool Matcher::IsSameTrainSet(const TrainIndex &entry, const std::vector<const data::Feature*> &features, const std::vector<int> &landmark_ids)
+{
+    // A row count alone matches any equally sized subset, so the landmark and arena row range must agree as well
+    return entry.descriptors.rows == features.size()
+        && entry.firstLandmarkId == landmark_ids.front()
+        && entry.lastLandmarkId == landmark_ids.back()
+        && entry.firstDescriptorIndex == features.front()->GetDescriptorIndex()
+        && entry.lastDescriptorIndex == features.back()->GetDescriptorIndex();
+}
+
+cv::Mat Matcher::StackDescriptors(const std::vector<const data::Feature*> &features)
+{
+    if (features.empty())
+    {
+        return cv::Mat();
+    }
+    // Features whose descriptors are consecutive rows of one frame arena are matched in place
+    const int firstIndex = features[0]->GetDescriptorIndex();
+    bool contiguous = firstIndex >= 0;
+    for (int i = 1; i < features.size() && contiguous; i++)
+    {
+        contiguous = &features[i]->GetFrame() == &features[0]->GetFrame() && features[i]->IsStereo() == features[0]->IsStereo() && features[i]->GetDescriptorIndex() == firstIndex + i;
+    }
+    if (contiguous)
+    {
+        return features[0]->GetFrame().GetDescriptors(features[0]->IsStereo()).rowRange(firstIndex, firstIndex + features.size());
+    }
+    cv::Mat first = features[0]->GetDescriptor();
+    cv::Mat descriptors(features.size(), first.cols, first.type());
+    for (int i = 0; i < features.size(); i++)
+    {
+        features[i]->GetDescriptor().copyTo(descriptors.row(i));
+    }
+    return descriptors;
+}
+
+cv::Mat Matcher::GetIndexDescriptors(const cv::Mat &descriptors) const
+{
+    if (binary_ || descriptors.type() == CV_32F)
+    {
+        return descriptors;
+    }
+    cv::Mat floatDescriptors;
+    descriptors.convertTo(floatDescriptors, CV_32F);
+    return floatDescriptors;
+}
+
+cv::Ptr<cv::flann::Index> Matcher::BuildIndex(const cv::Mat &index_descriptors) const
+{
+    // FLANN keeps a pointer to the descriptor data, so index_descriptors must outlive the index
+    if (binary_)
+    {
+        return cv::makePtr<cv::flann::Index>(index_descriptors, cv::flann::LshIndexParams(lshTables_, lshKeySize_, lshProbeLevel_), cvflann::FLANN_DIST_HAMMING);
+    }
+    return cv::makePtr<cv::flann::Index>(index_descriptors, cv::flann::KDTreeIndexParams(annTrees_), cvflann::FLANN_DIST_L2);
+}
+
+void Matcher::MatchApproximate(const cv::Mat &query, cv::flann::Index &query_index, const cv::Mat &train, cv::flann::Index &train_index, std::vector<cv::DMatch> &matches, std::vector<float> &second_distances) const
+{
+    cv::Mat indices;
+    cv::Mat dists;
+    matches.clear();
+    second_distances.clear();
+    if (ratioTest_)
+    {
+        const int knn = std::min(2, train.rows);
+        train_index.knnSearch(query, indices, dists, knn, cv::flann::SearchParams(annChecks_));
+        dists.convertTo(dists, CV_32F);
+        for (int i = 0; i < indices.rows; i++)
+        {
+            int trainIdx = indices.at<int>(i, 0);
+            if (trainIdx < 0 || trainIdx >= train.rows)
+            {
+                continue;
+            }
+            float dist = dists.at<float>(i, 0);
+            float secondDist = knn > 1 && indices.at<int>(i, 1) >= 0 ? dists.at<float>(i, 1) : std::numeric_limits<float>::infinity();
+            matches.emplace_back(i, trainIdx, binary_ ? dist : std::sqrt(dist));
+            second_distances.push_back(binary_ ? secondDist : std::sqrt(secondDist));
+        }
+        return;
+    }
+    train_index.knnSearch(query, indices, dists, 1, cv::flann::SearchParams(annChecks_));
+    cv::Mat revIndices;
+    cv::Mat revDists;
+    query_index.knnSearch(train, revIndices, revDists, 1, cv::flann::SearchParams(annChecks_));
+    dists.convertTo(dists, CV_32F);
+
+    for (int i = 0; i < indices.rows; i++)
+    {
+        int trainIdx = indices.at<int>(i, 0);
+        // Cross-check against the reverse search, as BFMatcher does for the exact case
+        if (trainIdx < 0 || trainIdx >= train.rows || revIndices.at<int>(trainIdx, 0) != i)
+        {
+            continue;
+        }
+        float dist = dists.at<float>(i, 0);
+        matches.emplace_back(i, trainIdx, binary_ ? dist : std::sqrt(dist));
     }
-    return numMatches;
 }
 
 }
@@ -5,8 +5,10 @@
 #include <opencv2/xfeatures2d.hpp>
 #include "data/frame.h"
 #include "data/landmark.h"
+#include "hamming_matcher.h"
 #include <string>
 #include <vector>
+#include <map>
 
 namespace omni_slam
 {
@@ -16,13 +18,56 @@ namespace feature
 class Matcher
 {
 public:
-    Matcher(std::string descriptor_type, double max_dist = 0);
+    Matcher(std::string descriptor_type, double max_dist = 0, bool approximate = false, bool ratio_test = false, double max_ratio = 0);
 
     std::map<std::pair<int, int>, int> Match(const std::vector<data::Landmark> &train, const std::vector<data::Landmark> &query, std::vector<data::Landmark> &matches, std::vector<std::vector<double>> &distances, std::vector<int> &query_match_indices, bool stereo = false) const;
+    std::map<std::pair<int, int>, int> Match(const std::vector<data::Landmark> &train, const std::vector<data::Landmark> &query, std::vector<data::Landmark> &matches, std::vector<std::vector<double>> &distances, std::vector<std::vector<double>> &second_distances, std::vector<int> &query_match_indices, bool stereo = false) const;
+    void Index(const std::vector<data::Landmark> &train, bool stereo = false);
+
+    bool IsApproximate() const;
+    void SetApproximate(bool approximate);
+    bool IsRatioTest() const;
+
+protected:
+    double DescriptorDistance(const cv::Mat &desc1, const cv::Mat &desc2) const;
+
+    double maxDistance_;
 
 private:
+    struct TrainIndex
+    {
+        cv::Mat descriptors;
+        cv::Mat indexDescriptors;
+        cv::Ptr<cv::flann::Index> index;
+        int firstLandmarkId{-1};
+        int lastLandmarkId{-1};
+        int firstDescriptorIndex{-1};
+        int lastDescriptorIndex{-1};
+    };
+
+    static cv::Mat StackDescriptors(const std::vector<const data::Feature*> &features);
+    static void SetTrainIdentity(TrainIndex &entry, const std::vector<const data::Feature*> &features, const std::vector<int> &landmark_ids);
+    static bool IsSameTrainSet(const TrainIndex &entry, const std::vector<const data::Feature*> &features, const std::vector<int> &landmark_ids);
+    cv::Mat GetIndexDescriptors(const cv::Mat &descriptors) const;
+    cv::Ptr<cv::flann::Index> BuildIndex(const cv::Mat &index_descriptors) const;
+    void MatchExhaustive(const cv::Mat &query, const cv::Mat &train, std::vector<cv::DMatch> &matches, std::vector<float> &second_distances) const;
+    void MatchApproximate(const cv::Mat &query, cv::flann::Index &query_index, const cv::Mat &train, cv::flann::Index &train_index, std::vector<cv::DMatch> &matches, std::vector<float> &second_distances) const;
+
     cv::Ptr<cv::DescriptorMatcher> matcher_;
-    double maxDistance_;
+    cv::Ptr<cv::DescriptorMatcher> bestMatcher_;
+    HammingMatcher hammingMatcher_;
+    bool binary_{false};
+    bool approximate_;
+    bool ratioTest_;
+    double maxRatio_;
+    std::map<std::pair<int, bool>, TrainIndex> indices_;
+
+    const int annTrees_{4};
+    const int annChecks_{64};
+    const int lshTables_{12};
+    const int lshKeySize_{20};
+    const int lshProbeLevel_{2};
+    const int exhaustiveBlockSize_{128};
 };
 
 }
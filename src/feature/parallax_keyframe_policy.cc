@@ -0,0 +1,49 @@
+#include "parallax_keyframe_policy.h"
+
+#include "util/tf_util.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace omni_slam
+{
+namespace feature
+{
+
+ParallaxKeyframePolicy::ParallaxKeyframePolicy(const double min_parallax)
+    : minParallax_(min_parallax * M_PI / 180.)
+{
+}
+
+bool ParallaxKeyframePolicy::IsKeyframe(const std::vector<data::Landmark> &landmarks, const data::Frame &keyframe, const data::Frame &cur_frame, const int frames_since_keyframe) const
+{
+    // Bearings are compared in a common orientation when both poses are known so that pure rotation is not parallax,
+    // without poses the angle still includes the relative rotation
+    Matrix3d keyframeRot = Matrix3d::Identity();
+    Matrix3d curRot = Matrix3d::Identity();
+    if (keyframe.HasEstimatedPose() && (cur_frame.HasEstimatedPose() || cur_frame.HasPredictedPose()))
+    {
+        keyframeRot = util::TFUtil::GetRotationFromPoseMatrix(keyframe.GetEstimatedPose());
+        curRot = util::TFUtil::GetRotationFromPoseMatrix(cur_frame.HasEstimatedPose() ? cur_frame.GetEstimatedPose() : cur_frame.GetPredictedPose());
+    }
+    std::vector<double> angles;
+    for (const data::Landmark &landmark : landmarks)
+    {
+        const data::Feature *feat = landmark.GetObservationByFrameID(keyframe.GetID());
+        const data::Feature *curFeat = landmark.GetObservationByFrameID(cur_frame.GetID());
+        if (feat != nullptr && curFeat != nullptr)
+        {
+            double cosAngle = (keyframeRot * feat->GetBearing().normalized()).dot(curRot * curFeat->GetBearing().normalized());
+            angles.push_back(acos(std::min(std::max(cosAngle, -1.), 1.)));
+        }
+    }
+    if (angles.size() == 0)
+    {
+        return true;
+    }
+    std::nth_element(angles.begin(), angles.begin() + angles.size() / 2, angles.end());
+    return angles[angles.size() / 2] >= minParallax_;
+}
+
+}
+}
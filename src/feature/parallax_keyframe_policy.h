@@ -0,0 +1,25 @@
+#ifndef _PARALLAX_KEYFRAME_POLICY_H_
+#define _PARALLAX_KEYFRAME_POLICY_H_
+
+#include "keyframe_policy.h"
+
+namespace omni_slam
+{
+namespace feature
+{
+
+class ParallaxKeyframePolicy : public KeyframePolicy
+{
+public:
+    ParallaxKeyframePolicy(const double min_parallax);
+
+    bool IsKeyframe(const std::vector<data::Landmark> &landmarks, const data::Frame &keyframe, const data::Frame &cur_frame, const int frames_since_keyframe) const;
+
+private:
+    const double minParallax_;
+};
+
+}
+}
+
+#endif /* _PARALLAX_KEYFRAME_POLICY_H_ */
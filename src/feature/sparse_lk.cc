@@ -0,0 +1,397 @@
+#include "sparse_lk.h"
+
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+
+// Window kernels shared by all points. SSE2 is part of the x86-64 baseline, so these are vectorized in every build
+// there; other targets use the scalar loops.
+#ifdef __SSE2__
+inline float HorizontalSum(__m128 v)
+{
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+
+inline __m128 LoadBytes(const unsigned char *p)
+{
+    int packed;
+    std::memcpy(&packed, p, 4);
+    __m128i zero = _mm_setzero_si128();
+    __m128i x = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(x, zero));
+}
+
+inline void LoadDerivs(const short *p, __m128 &lo, __m128 &hi)
+{
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+    hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+}
+#endif
+
+void InterpolateRow(const unsigned char *row0, const unsigned char *row1, const float w00, const float w01, const float w10, const float w11, const int width, float *out)
+{
+    int x = 0;
+#ifdef __SSE2__
+    const __m128 v00 = _mm_set1_ps(w00);
+    const __m128 v01 = _mm_set1_ps(w01);
+    const __m128 v10 = _mm_set1_ps(w10);
+    const __m128 v11 = _mm_set1_ps(w11);
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128 top = _mm_add_ps(_mm_mul_ps(v00, LoadBytes(row0 + x)), _mm_mul_ps(v01, LoadBytes(row0 + x + 1)));
+        __m128 bottom = _mm_add_ps(_mm_mul_ps(v10, LoadBytes(row1 + x)), _mm_mul_ps(v11, LoadBytes(row1 + x + 1)));
+        _mm_storeu_ps(out + x, _mm_add_ps(top, bottom));
+    }
+#endif
+    for (; x < width; x++)
+    {
+        out[x] = w00 * row0[x] + w01 * row0[x + 1] + w10 * row1[x] + w11 * row1[x + 1];
+    }
+}
+
+void InterpolateDerivRow(const short *row0, const short *row1, const float w00, const float w01, const float w10, const float w11, const int width, float *dx, float *dy)
+{
+    int x = 0;
+#ifdef __SSE2__
+    const __m128 v00 = _mm_set1_ps(w00);
+    const __m128 v01 = _mm_set1_ps(w01);
+    const __m128 v10 = _mm_set1_ps(w10);
+    const __m128 v11 = _mm_set1_ps(w11);
+    for (; x + 4 <= width; x += 4)
+    {
+        // Each load holds four interleaved (dx, dy) pairs
+        __m128 a0, a1, b0, b1, c0, c1, d0, d1;
+        LoadDerivs(row0 + 2 * x, a0, a1);
+        LoadDerivs(row0 + 2 * x + 2, b0, b1);
+        LoadDerivs(row1 + 2 * x, c0, c1);
+        LoadDerivs(row1 + 2 * x + 2, d0, d1);
+        __m128 lo = _mm_add_ps(_mm_add_ps(_mm_mul_ps(v00, a0), _mm_mul_ps(v01, b0)), _mm_add_ps(_mm_mul_ps(v10, c0), _mm_mul_ps(v11, d0)));
+        __m128 hi = _mm_add_ps(_mm_add_ps(_mm_mul_ps(v00, a1), _mm_mul_ps(v01, b1)), _mm_add_ps(_mm_mul_ps(v10, c1), _mm_mul_ps(v11, d1)));
+        _mm_storeu_ps(dx + x, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(dy + x, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#endif
+    for (; x < width; x++)
+    {
+        dx[x] = w00 * row0[2 * x] + w01 * row0[2 * x + 2] + w10 * row1[2 * x] + w11 * row1[2 * x + 2];
+        dy[x] = w00 * row0[2 * x + 1] + w01 * row0[2 * x + 3] + w10 * row1[2 * x + 1] + w11 * row1[2 * x + 3];
+    }
+}
+
+void AccumulateHessian(const float *gx, const float *gy, const int n, float &a11, float &a12, float &a22)
+{
+    a11 = 0;
+    a12 = 0;
+    a22 = 0;
+    int k = 0;
+#ifdef __SSE2__
+    __m128 s11 = _mm_setzero_ps();
+    __m128 s12 = _mm_setzero_ps();
+    __m128 s22 = _mm_setzero_ps();
+    for (; k + 4 <= n; k += 4)
+    {
+        __m128 x = _mm_loadu_ps(gx + k);
+        __m128 y = _mm_loadu_ps(gy + k);
+        s11 = _mm_add_ps(s11, _mm_mul_ps(x, x));
+        s12 = _mm_add_ps(s12, _mm_mul_ps(x, y));
+        s22 = _mm_add_ps(s22, _mm_mul_ps(y, y));
+    }
+    a11 = HorizontalSum(s11);
+    a12 = HorizontalSum(s12);
+    a22 = HorizontalSum(s22);
+#endif
+    for (; k < n; k++)
+    {
+        a11 += gx[k] * gx[k];
+        a12 += gx[k] * gy[k];
+        a22 += gy[k] * gy[k];
+    }
+}
+
+void AccumulateMismatch(const float *warped, const float *templ, const float *gx, const float *gy, const int n, float &b1, float &b2)
+{
+    b1 = 0;
+    b2 = 0;
+    int k = 0;
+#ifdef __SSE2__
+    __m128 s1 = _mm_setzero_ps();
+    __m128 s2 = _mm_setzero_ps();
+    for (; k + 4 <= n; k += 4)
+    {
+        __m128 diff = _mm_sub_ps(_mm_loadu_ps(warped + k), _mm_loadu_ps(templ + k));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(diff, _mm_loadu_ps(gx + k)));
+        s2 = _mm_add_ps(s2, _mm_mul_ps(diff, _mm_loadu_ps(gy + k)));
+    }
+    b1 = HorizontalSum(s1);
+    b2 = HorizontalSum(s2);
+#endif
+    for (; k < n; k++)
+    {
+        float diff = warped[k] - templ[k];
+        b1 += diff * gx[k];
+        b2 += diff * gy[k];
+    }
+}
+
+float SumAbsDiff(const float *a, const float *b, const int n)
+{
+    float sum = 0;
+    int k = 0;
+#ifdef __SSE2__
+    const __m128 signMask = _mm_set1_ps(-0.f);
+    __m128 acc = _mm_setzero_ps();
+    for (; k + 4 <= n; k += 4)
+    {
+        acc = _mm_add_ps(acc, _mm_andnot_ps(signMask, _mm_sub_ps(_mm_loadu_ps(a + k), _mm_loadu_ps(b + k))));
+    }
+    sum = HorizontalSum(acc);
+#endif
+    for (; k < n; k++)
+    {
+        sum += std::abs(a[k] - b[k]);
+    }
+    return sum;
+}
+
+}
+
+namespace omni_slam
+{
+namespace feature
+{
+
+SparseLK::SparseLK(const cv::Size &window_size, const int num_scales, const cv::TermCriteria &term_crit, const double min_eig_thresh, const double min_window_scale)
+    : windowSize_(window_size),
+    numScales_(num_scales),
+    termCrit_(term_crit),
+    minEigThresh_(min_eig_thresh),
+    minWindowScale_(min_window_scale)
+{
+}
+
+void SparseLK::Track(const std::vector<cv::Mat> &prev_pyramid, const std::vector<cv::Mat> &next_pyramid, const std::vector<cv::Point2f> &prev_pts, std::vector<cv::Point2f> &next_pts, const std::vector<float> &window_scales, std::vector<unsigned char> &status, std::vector<float> &err, const bool use_initial_flow) const
+{
+    next_pts.resize(prev_pts.size());
+    status.assign(prev_pts.size(), 0);
+    err.assign(prev_pts.size(), 0.f);
+    if (prev_pyramid.empty() || next_pyramid.empty())
+    {
+        return;
+    }
+
+    std::vector<cv::Mat> derivPyramid;
+    const std::vector<cv::Mat> *prevPyramid = &prev_pyramid;
+    if (prev_pyramid.size() < 2 || prev_pyramid[0].type() == prev_pyramid[1].type())
+    {
+        cv::buildOpticalFlowPyramid(prev_pyramid[0], derivPyramid, windowSize_, numScales_, true);
+        prevPyramid = &derivPyramid;
+    }
+    int nextStride = next_pyramid.size() > 1 && next_pyramid[0].type() != next_pyramid[1].type() ? 2 : 1;
+    int maxLevel = std::min({numScales_, (int)prevPyramid->size() / 2 - 1, ((int)next_pyramid.size() + nextStride - 1) / nextStride - 1});
+
+    std::vector<int> halfWidths(prev_pts.size());
+    std::vector<int> halfHeights(prev_pts.size());
+    int maxArea = 0;
+    for (int i = 0; i < prev_pts.size(); i++)
+    {
+        float scale = window_scales.empty() ? 1.f : std::min(std::max(window_scales[i], (float)minWindowScale_), (float)(1. / minWindowScale_));
+        halfWidths[i] = std::max(1, (int)std::round((windowSize_.width - 1) * 0.5f * scale));
+        halfHeights[i] = std::max(1, (int)std::round((windowSize_.height - 1) * 0.5f * scale));
+        maxArea = std::max(maxArea, (2 * halfWidths[i] + 1) * (2 * halfHeights[i] + 1));
+    }
+    // One scratch block per call (a call covers one chunk on one thread) holds the template, gradients and warped window
+    std::vector<float> scratch(4 * maxArea);
+
+    for (int i = 0; i < prev_pts.size(); i++)
+    {
+        cv::Point2f nextPt = use_initial_flow ? next_pts[i] : prev_pts[i];
+        float error;
+        if (TrackPoint(*prevPyramid, next_pyramid, nextStride, maxLevel, prev_pts[i], nextPt, halfWidths[i], halfHeights[i], scratch.data(), error))
+        {
+            status[i] = 1;
+            err[i] = error;
+        }
+        next_pts[i] = nextPt;
+    }
+}
+
+bool SparseLK::TrackPoint(const std::vector<cv::Mat> &prev_pyramid, const std::vector<cv::Mat> &next_pyramid, const int next_stride, const int max_level, const cv::Point2f &prev_pt, cv::Point2f &next_pt, const int half_width, const int half_height, float *scratch, float &err) const
+{
+    const int winArea = (2 * half_width + 1) * (2 * half_height + 1);
+    float *templ = scratch;
+    float *gradX = scratch + winArea;
+    float *gradY = scratch + 2 * winArea;
+    float *warped = scratch + 3 * winArea;
+
+    cv::Point2f nextPt = next_pt * (1.f / (1 << max_level));
+    for (int level = max_level; level >= 0; level--)
+    {
+        const cv::Mat &prevImg = prev_pyramid[level * 2];
+        const cv::Mat &prevDeriv = prev_pyramid[level * 2 + 1];
+        const cv::Mat &nextImg = next_pyramid[level * next_stride];
+        cv::Point2f prevPt = prev_pt * (1.f / (1 << level));
+
+        if (prevPt.x < -half_width || prevPt.x >= prevImg.cols + half_width || prevPt.y < -half_height || prevPt.y >= prevImg.rows + half_height)
+        {
+            if (level == 0)
+            {
+                return false;
+            }
+            nextPt *= 2.f;
+            continue;
+        }
+
+        SampleWindow(prevImg, prevPt, half_width, half_height, templ);
+        SampleDerivWindow(prevDeriv, prevPt, half_width, half_height, gradX, gradY);
+        float a11, a12, a22;
+        AccumulateHessian(gradX, gradY, winArea, a11, a12, a22);
+        float det = a11 * a22 - a12 * a12;
+        float minEig = (a22 + a11 - std::sqrt((a11 - a22) * (a11 - a22) + 4.f * a12 * a12)) / (2 * winArea);
+        if (minEig < minEigThresh_ || det < FLT_EPSILON)
+        {
+            if (level == 0)
+            {
+                return false;
+            }
+            nextPt *= 2.f;
+            continue;
+        }
+        det = 1.f / det;
+
+        cv::Point2f prevDelta;
+        for (int j = 0; j < termCrit_.maxCount; j++)
+        {
+            if (nextPt.x < -half_width || nextPt.x >= nextImg.cols + half_width || nextPt.y < -half_height || nextPt.y >= nextImg.rows + half_height)
+            {
+                if (level == 0)
+                {
+                    return false;
+                }
+                break;
+            }
+            SampleWindow(nextImg, nextPt, half_width, half_height, warped);
+            float b1, b2;
+            AccumulateMismatch(warped, templ, gradX, gradY, winArea, b1, b2);
+            cv::Point2f delta((a12 * b2 - a22 * b1) * det, (a12 * b1 - a11 * b2) * det);
+            nextPt += delta;
+            if (delta.ddot(delta) <= termCrit_.epsilon * termCrit_.epsilon)
+            {
+                break;
+            }
+            if (j > 0 && std::abs(delta.x + prevDelta.x) < 0.01 && std::abs(delta.y + prevDelta.y) < 0.01)
+            {
+                nextPt -= delta * 0.5f;
+                break;
+            }
+            prevDelta = delta;
+        }
+
+        if (level > 0)
+        {
+            nextPt *= 2.f;
+        }
+    }
+
+    next_pt = nextPt;
+    const cv::Mat &nextImg = next_pyramid[0];
+    if (nextPt.x < 0 || nextPt.x >= nextImg.cols || nextPt.y < 0 || nextPt.y >= nextImg.rows)
+    {
+        return false;
+    }
+    SampleWindow(nextImg, nextPt, half_width, half_height, warped);
+    err = SumAbsDiff(warped, templ, winArea) / winArea;
+    return true;
+}
+
+void SparseLK::SampleWindow(const cv::Mat &image, const cv::Point2f &pt, const int half_width, const int half_height, float *values) const
+{
+    const float fx = std::floor(pt.x);
+    const float fy = std::floor(pt.y);
+    const float ax = pt.x - fx;
+    const float ay = pt.y - fy;
+    const float w00 = (1.f - ax) * (1.f - ay);
+    const float w01 = ax * (1.f - ay);
+    const float w10 = (1.f - ax) * ay;
+    const float w11 = ax * ay;
+    const int x0 = (int)fx - half_width;
+    const int y0 = (int)fy - half_height;
+    const int width = 2 * half_width + 1;
+    const int height = 2 * half_height + 1;
+
+    if (x0 >= 0 && y0 >= 0 && x0 + width < image.cols && y0 + height < image.rows)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            InterpolateRow(image.ptr<unsigned char>(y0 + y) + x0, image.ptr<unsigned char>(y0 + y + 1) + x0, w00, w01, w10, w11, width, values + y * width);
+        }
+        return;
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        const unsigned char *row0 = image.ptr<unsigned char>(std::min(std::max(y0 + y, 0), image.rows - 1));
+        const unsigned char *row1 = image.ptr<unsigned char>(std::min(std::max(y0 + y + 1, 0), image.rows - 1));
+        float *out = values + y * width;
+        for (int x = 0; x < width; x++)
+        {
+            int xa = std::min(std::max(x0 + x, 0), image.cols - 1);
+            int xb = std::min(std::max(x0 + x + 1, 0), image.cols - 1);
+            out[x] = w00 * row0[xa] + w01 * row0[xb] + w10 * row1[xa] + w11 * row1[xb];
+        }
+    }
+}
+
+void SparseLK::SampleDerivWindow(const cv::Mat &deriv, const cv::Point2f &pt, const int half_width, const int half_height, float *dx, float *dy) const
+{
+    const float fx = std::floor(pt.x);
+    const float fy = std::floor(pt.y);
+    const float ax = pt.x - fx;
+    const float ay = pt.y - fy;
+    // Scharr derivatives are scaled by 32 relative to the intensity gradient
+    const float w00 = (1.f - ax) * (1.f - ay) / 32.f;
+    const float w01 = ax * (1.f - ay) / 32.f;
+    const float w10 = (1.f - ax) * ay / 32.f;
+    const float w11 = ax * ay / 32.f;
+    const int x0 = (int)fx - half_width;
+    const int y0 = (int)fy - half_height;
+    const int width = 2 * half_width + 1;
+    const int height = 2 * half_height + 1;
+
+    if (x0 >= 0 && y0 >= 0 && x0 + width < deriv.cols && y0 + height < deriv.rows)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            InterpolateDerivRow(deriv.ptr<short>(y0 + y) + 2 * x0, deriv.ptr<short>(y0 + y + 1) + 2 * x0, w00, w01, w10, w11, width, dx + y * width, dy + y * width);
+        }
+        return;
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        const short *row0 = deriv.ptr<short>(std::min(std::max(y0 + y, 0), deriv.rows - 1));
+        const short *row1 = deriv.ptr<short>(std::min(std::max(y0 + y + 1, 0), deriv.rows - 1));
+        float *outX = dx + y * width;
+        float *outY = dy + y * width;
+        for (int x = 0; x < width; x++)
+        {
+            int xa = 2 * std::min(std::max(x0 + x, 0), deriv.cols - 1);
+            int xb = 2 * std::min(std::max(x0 + x + 1, 0), deriv.cols - 1);
+            outX[x] = w00 * row0[xa] + w01 * row0[xb] + w10 * row1[xa] + w11 * row1[xb];
+            outY[x] = w00 * row0[xa + 1] + w01 * row0[xb + 1] + w10 * row1[xa + 1] + w11 * row1[xb + 1];
+        }
+    }
+}
+
+}
+}
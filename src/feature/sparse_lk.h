@@ -0,0 +1,34 @@
+#ifndef _SPARSE_LK_H_
+#define _SPARSE_LK_H_
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace omni_slam
+{
+namespace feature
+{
+
+class SparseLK
+{
+public:
+    SparseLK(const cv::Size &window_size, const int num_scales, const cv::TermCriteria &term_crit, const double min_eig_thresh = 1e-4, const double min_window_scale = 0.25);
+
+    void Track(const std::vector<cv::Mat> &prev_pyramid, const std::vector<cv::Mat> &next_pyramid, const std::vector<cv::Point2f> &prev_pts, std::vector<cv::Point2f> &next_pts, const std::vector<float> &window_scales, std::vector<unsigned char> &status, std::vector<float> &err, const bool use_initial_flow) const;
+
+private:
+    bool TrackPoint(const std::vector<cv::Mat> &prev_pyramid, const std::vector<cv::Mat> &next_pyramid, const int next_stride, const int max_level, const cv::Point2f &prev_pt, cv::Point2f &next_pt, const int half_width, const int half_height, float *scratch, float &err) const;
+    void SampleWindow(const cv::Mat &image, const cv::Point2f &pt, const int half_width, const int half_height, float *values) const;
+    void SampleDerivWindow(const cv::Mat &deriv, const cv::Point2f &pt, const int half_width, const int half_height, float *dx, float *dy) const;
+
+    const cv::Size windowSize_;
+    const int numScales_;
+    const cv::TermCriteria termCrit_;
+    const double minEigThresh_;
+    const double minWindowScale_;
+};
+
+}
+}
+
+#endif /* _SPARSE_LK_H_ */
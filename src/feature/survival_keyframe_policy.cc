@@ -0,0 +1,36 @@
+#include "survival_keyframe_policy.h"
+
+namespace omni_slam
+{
+namespace feature
+{
+
+SurvivalKeyframePolicy::SurvivalKeyframePolicy(const double min_survival_ratio)
+    : minSurvivalRatio_(min_survival_ratio)
+{
+}
+
+bool SurvivalKeyframePolicy::IsKeyframe(const std::vector<data::Landmark> &landmarks, const data::Frame &keyframe, const data::Frame &cur_frame, const int frames_since_keyframe) const
+{
+    int numKeyframeTracks = 0;
+    int numSurvived = 0;
+    for (const data::Landmark &landmark : landmarks)
+    {
+        if (!landmark.IsTerminated() && landmark.IsObservedInFrame(keyframe.GetID()))
+        {
+            numKeyframeTracks++;
+            if (landmark.IsObservedInFrame(cur_frame.GetID()))
+            {
+                numSurvived++;
+            }
+        }
+    }
+    if (numKeyframeTracks == 0)
+    {
+        return true;
+    }
+    return numSurvived < minSurvivalRatio_ * numKeyframeTracks;
+}
+
+}
+}
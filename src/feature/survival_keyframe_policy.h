@@ -0,0 +1,25 @@
+#ifndef _SURVIVAL_KEYFRAME_POLICY_H_
+#define _SURVIVAL_KEYFRAME_POLICY_H_
+
+#include "keyframe_policy.h"
+
+namespace omni_slam
+{
+namespace feature
+{
+
+class SurvivalKeyframePolicy : public KeyframePolicy
+{
+public:
+    SurvivalKeyframePolicy(const double min_survival_ratio);
+
+    bool IsKeyframe(const std::vector<data::Landmark> &landmarks, const data::Frame &keyframe, const data::Frame &cur_frame, const int frames_since_keyframe) const;
+
+private:
+    const double minSurvivalRatio_;
+};
+
+}
+}
+
+#endif /* _SURVIVAL_KEYFRAME_POLICY_H_ */
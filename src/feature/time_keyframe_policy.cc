@@ -0,0 +1,19 @@
+#include "time_keyframe_policy.h"
+
+namespace omni_slam
+{
+namespace feature
+{
+
+TimeKeyframePolicy::TimeKeyframePolicy(const double max_time)
+    : maxTime_(max_time)
+{
+}
+
+bool TimeKeyframePolicy::IsKeyframe(const std::vector<data::Landmark> &landmarks, const data::Frame &keyframe, const data::Frame &cur_frame, const int frames_since_keyframe) const
+{
+    return cur_frame.GetTime() - keyframe.GetTime() >= maxTime_;
+}
+
+}
+}
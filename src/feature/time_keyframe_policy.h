@@ -0,0 +1,25 @@
+#ifndef _TIME_KEYFRAME_POLICY_H_
+#define _TIME_KEYFRAME_POLICY_H_
+
+#include "keyframe_policy.h"
+
+namespace omni_slam
+{
+namespace feature
+{
+
+class TimeKeyframePolicy : public KeyframePolicy
+{
+public:
+    TimeKeyframePolicy(const double max_time);
+
+    bool IsKeyframe(const std::vector<data::Landmark> &landmarks, const data::Frame &keyframe, const data::Frame &cur_frame, const int frames_since_keyframe) const;
+
+private:
+    const double maxTime_;
+};
+
+}
+}
+
+#endif /* _TIME_KEYFRAME_POLICY_H_ */
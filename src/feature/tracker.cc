@@ -1,4 +1,5 @@
 #include "tracker.h"
+#include "interval_keyframe_policy.h"
 
 namespace omni_slam
 {
@@ -6,11 +7,21 @@ namespace feature
 {
 
 Tracker::Tracker(const int keyframe_interval)
-    : keyframeInterval_(keyframe_interval),
+    : keyframePolicy_(new IntervalKeyframePolicy(keyframe_interval)),
     prevFrame_(nullptr)
 {
 }
 
+void Tracker::SetKeyframePolicy(std::unique_ptr<KeyframePolicy> &keyframe_policy)
+{
+    keyframePolicy_ = std::move(keyframe_policy);
+}
+
+void Tracker::SetKeyframePolicy(std::unique_ptr<KeyframePolicy> &&keyframe_policy)
+{
+    SetKeyframePolicy(keyframe_policy);
+}
+
 void Tracker::Init(data::Frame &init_frame)
 {
     frameNum_ = 0;
@@ -30,6 +41,16 @@ const data::Frame* Tracker::GetLastKeyframe()
     return keyframe_;
 }
 
+int Tracker::GetLastRejectedCount() const
+{
+    return numRejected_;
+}
+
+const std::vector<double>& Tracker::GetLastKernelBenchmark() const
+{
+    return kernelBenchmark_;
+}
+
 int Tracker::Track(std::vector<data::Landmark> &landmarks, data::Frame &cur_frame, std::vector<double> &errors, bool stereo)
 {
     if (keyframeImg_.empty())
@@ -37,13 +58,16 @@ int Tracker::Track(std::vector<data::Landmark> &landmarks, data::Frame &cur_fram
         return 0;
     }
     bool wasCompressed = cur_frame.IsCompressed();
+    numRejected_ = 0;
+    kernelBenchmark_.clear();
 
     int count = DoTrack(landmarks, cur_frame, errors, stereo);
 
     prevId_ = cur_frame.GetID();
     prevFrame_ = &cur_frame;
-    if (++frameNum_ % keyframeInterval_ == 0)
+    if (keyframePolicy_->IsKeyframe(landmarks, *keyframe_, cur_frame, ++frameNum_))
     {
+        frameNum_ = 0;
         keyframe_ = &cur_frame;
         keyframeId_ = cur_frame.GetID();
         keyframeImg_ = cur_frame.GetImage().clone();
@@ -3,6 +3,8 @@
 
 #include "data/frame.h"
 #include "data/landmark.h"
+#include "keyframe_policy.h"
+#include <memory>
 
 namespace omni_slam
 {
@@ -14,10 +16,15 @@ class Tracker
 public:
     Tracker(const int keyframe_interval = 1);
 
+    void SetKeyframePolicy(std::unique_ptr<KeyframePolicy> &keyframe_policy);
+    void SetKeyframePolicy(std::unique_ptr<KeyframePolicy> &&keyframe_policy);
+
     virtual void Init(data::Frame &init_frame);
     int Track(std::vector<data::Landmark> &landmarks, data::Frame &cur_frame, std::vector<double> &errors, bool stereo = true);
 
     const data::Frame* GetLastKeyframe();
+    int GetLastRejectedCount() const;
+    const std::vector<double>& GetLastKernelBenchmark() const;
 
 protected:
     cv::Mat keyframeImg_;
@@ -26,12 +33,14 @@ protected:
     int prevId_;
     const data::Frame *prevFrame_;
     const data::Frame *keyframe_;
+    int numRejected_{0};
+    std::vector<double> kernelBenchmark_;
 
 private:
     virtual int DoTrack(std::vector<data::Landmark> &landmarks, data::Frame &cur_frame, std::vector<double> &errors, bool stereo) = 0;
 
     int frameNum_{0};
-    const int keyframeInterval_;
+    std::shared_ptr<KeyframePolicy> keyframePolicy_;
 };
 
 }
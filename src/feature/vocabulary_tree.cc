@@ -0,0 +1,288 @@
+#include "vocabulary_tree.h"
+#include "hamming_matcher.h"
+
+#include <cmath>
+#include <cfloat>
+#include <climits>
+#include <set>
+#include <numeric>
+
+namespace omni_slam
+{
+namespace feature
+{
+
+VocabularyTree::VocabularyTree(const int branching, const int depth, const int max_iterations)
+    : branching_(branching),
+    depth_(depth),
+    maxIterations_(max_iterations)
+{
+}
+
+void VocabularyTree::Train(const std::vector<cv::Mat> &descriptors)
+{
+    cv::Mat data;
+    std::vector<int> image;
+    for (int i = 0; i < descriptors.size(); i++)
+    {
+        if (descriptors[i].empty())
+        {
+            continue;
+        }
+        data.push_back(descriptors[i]);
+        image.insert(image.end(), descriptors[i].rows, i);
+    }
+    nodes_.clear();
+    idf_.clear();
+    numWords_ = 0;
+    if (data.empty())
+    {
+        return;
+    }
+    binary_ = data.type() == CV_8U;
+
+    std::vector<int> indices(data.rows);
+    std::iota(indices.begin(), indices.end(), 0);
+    nodes_.emplace_back();
+    Build(data, indices, 0, 0);
+
+    // Inverse document frequency over the training images
+    std::vector<std::set<int>> wordImages(numWords_);
+    for (int r = 0; r < data.rows; r++)
+    {
+        wordImages[Quantize(data.row(r))].insert(image[r]);
+    }
+    idf_.resize(numWords_, 0.);
+    for (int w = 0; w < numWords_; w++)
+    {
+        if (!wordImages[w].empty())
+        {
+            idf_[w] = std::log((double)descriptors.size() / wordImages[w].size());
+        }
+    }
+}
+
+bool VocabularyTree::IsTrained() const
+{
+    return numWords_ > 0;
+}
+
+int VocabularyTree::GetNumWords() const
+{
+    return numWords_;
+}
+
+int VocabularyTree::Quantize(const cv::Mat &descriptor) const
+{
+    if (nodes_.empty())
+    {
+        return -1;
+    }
+    int node = 0;
+    while (!nodes_[node].children.empty())
+    {
+        int best = nodes_[node].children[0];
+        double bestDist = DBL_MAX;
+        for (int child : nodes_[node].children)
+        {
+            double dist = Distance(descriptor, nodes_[child].center);
+            if (dist < bestDist)
+            {
+                bestDist = dist;
+                best = child;
+            }
+        }
+        node = best;
+    }
+    return nodes_[node].word;
+}
+
+void VocabularyTree::Transform(const cv::Mat &descriptors, std::map<int, double> &bow) const
+{
+    bow.clear();
+    if (!IsTrained() || descriptors.empty())
+    {
+        return;
+    }
+    for (int r = 0; r < descriptors.rows; r++)
+    {
+        int word = Quantize(descriptors.row(r));
+        if (word >= 0)
+        {
+            bow[word] += 1.;
+        }
+    }
+    double norm = 0;
+    for (auto it = bow.begin(); it != bow.end();)
+    {
+        it->second *= idf_[it->first];
+        if (it->second <= 0)
+        {
+            it = bow.erase(it);
+            continue;
+        }
+        norm += it->second;
+        ++it;
+    }
+    if (norm > 0)
+    {
+        for (auto &entry : bow)
+        {
+            entry.second /= norm;
+        }
+    }
+}
+
+void VocabularyTree::Build(const cv::Mat &descriptors, const std::vector<int> &indices, const int node, const int level)
+{
+    if (level >= depth_ || indices.size() <= branching_)
+    {
+        nodes_[node].word = numWords_++;
+        return;
+    }
+    std::vector<cv::Mat> centers;
+    std::vector<std::vector<int>> clusters;
+    Cluster(descriptors, indices, centers, clusters);
+    if (centers.size() < 2)
+    {
+        nodes_[node].word = numWords_++;
+        return;
+    }
+    for (int c = 0; c < centers.size(); c++)
+    {
+        int child = nodes_.size();
+        nodes_.emplace_back();
+        nodes_[child].center = centers[c];
+        nodes_[node].children.push_back(child);
+    }
+    for (int c = 0; c < centers.size(); c++)
+    {
+        Build(descriptors, clusters[c], nodes_[node].children[c], level + 1);
+    }
+}
+
+void VocabularyTree::Cluster(const cv::Mat &descriptors, const std::vector<int> &indices, std::vector<cv::Mat> &centers, std::vector<std::vector<int>> &clusters) const
+{
+    centers.clear();
+    clusters.clear();
+    if (!binary_)
+    {
+        cv::Mat samples(indices.size(), descriptors.cols, CV_32F);
+        for (int i = 0; i < indices.size(); i++)
+        {
+            descriptors.row(indices[i]).convertTo(samples.row(i), CV_32F);
+        }
+        cv::Mat labels;
+        cv::Mat kmCenters;
+        cv::kmeans(samples, branching_, labels, cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, maxIterations_, 1e-3), 1, cv::KMEANS_PP_CENTERS, kmCenters);
+        std::vector<std::vector<int>> groups(branching_);
+        for (int i = 0; i < indices.size(); i++)
+        {
+            groups[labels.at<int>(i)].push_back(indices[i]);
+        }
+        for (int c = 0; c < branching_; c++)
+        {
+            if (!groups[c].empty())
+            {
+                cv::Mat center;
+                kmCenters.row(c).convertTo(center, descriptors.type());
+                centers.push_back(center);
+                clusters.push_back(std::move(groups[c]));
+            }
+        }
+        return;
+    }
+
+    // k-majority: Hamming assignment with per-bit majority vote centers, seeded on evenly spaced samples
+    std::vector<cv::Mat> seeds;
+    for (int c = 0; c < branching_; c++)
+    {
+        seeds.push_back(descriptors.row(indices[(size_t)c * indices.size() / branching_]).clone());
+    }
+    std::vector<int> labels(indices.size(), -1);
+    for (int iter = 0; iter < maxIterations_; iter++)
+    {
+        bool changed = false;
+        for (int i = 0; i < indices.size(); i++)
+        {
+            const unsigned char *desc = descriptors.ptr<unsigned char>(indices[i]);
+            int best = 0;
+            int bestDist = INT_MAX;
+            for (int c = 0; c < seeds.size(); c++)
+            {
+                int dist = HammingMatcher::Distance(desc, seeds[c].ptr<unsigned char>(), descriptors.cols);
+                if (dist < bestDist)
+                {
+                    bestDist = dist;
+                    best = c;
+                }
+            }
+            if (labels[i] != best)
+            {
+                labels[i] = best;
+                changed = true;
+            }
+        }
+        if (!changed)
+        {
+            break;
+        }
+        std::vector<std::vector<int>> bitCounts(seeds.size(), std::vector<int>(descriptors.cols * 8, 0));
+        std::vector<int> sizes(seeds.size(), 0);
+        for (int i = 0; i < indices.size(); i++)
+        {
+            const unsigned char *desc = descriptors.ptr<unsigned char>(indices[i]);
+            std::vector<int> &counts = bitCounts[labels[i]];
+            for (int b = 0; b < descriptors.cols * 8; b++)
+            {
+                counts[b] += (desc[b / 8] >> (7 - b % 8)) & 1;
+            }
+            sizes[labels[i]]++;
+        }
+        for (int c = 0; c < seeds.size(); c++)
+        {
+            if (sizes[c] == 0)
+            {
+                continue;
+            }
+            unsigned char *center = seeds[c].ptr<unsigned char>();
+            for (int j = 0; j < descriptors.cols; j++)
+            {
+                unsigned char byte = 0;
+                for (int b = 0; b < 8; b++)
+                {
+                    if (2 * bitCounts[c][j * 8 + b] > sizes[c])
+                    {
+                        byte |= 1 << (7 - b);
+                    }
+                }
+                center[j] = byte;
+            }
+        }
+    }
+    std::vector<std::vector<int>> groups(seeds.size());
+    for (int i = 0; i < indices.size(); i++)
+    {
+        groups[labels[i]].push_back(indices[i]);
+    }
+    for (int c = 0; c < seeds.size(); c++)
+    {
+        if (!groups[c].empty())
+        {
+            centers.push_back(seeds[c]);
+            clusters.push_back(std::move(groups[c]));
+        }
+    }
+}
+
+double VocabularyTree::Distance(const cv::Mat &desc1, const cv::Mat &desc2) const
+{
+    if (binary_)
+    {
+        return HammingMatcher::Distance(desc1.ptr<unsigned char>(), desc2.ptr<unsigned char>(), desc1.cols);
+    }
+    return cv::norm(desc1, desc2, cv::NORM_L2);
+}
+
+}
+}
@@ -0,0 +1,49 @@
+#ifndef _VOCABULARY_TREE_H_
+#define _VOCABULARY_TREE_H_
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <map>
+
+namespace omni_slam
+{
+namespace feature
+{
+
+class VocabularyTree
+{
+public:
+    VocabularyTree(const int branching = 10, const int depth = 4, const int max_iterations = 10);
+
+    void Train(const std::vector<cv::Mat> &descriptors);
+    bool IsTrained() const;
+    int GetNumWords() const;
+
+    int Quantize(const cv::Mat &descriptor) const;
+    void Transform(const cv::Mat &descriptors, std::map<int, double> &bow) const;
+
+private:
+    struct Node
+    {
+        cv::Mat center;
+        std::vector<int> children;
+        int word{-1};
+    };
+
+    void Build(const cv::Mat &descriptors, const std::vector<int> &indices, const int node, const int level);
+    void Cluster(const cv::Mat &descriptors, const std::vector<int> &indices, std::vector<cv::Mat> &centers, std::vector<std::vector<int>> &clusters) const;
+    double Distance(const cv::Mat &desc1, const cv::Mat &desc2) const;
+
+    const int branching_;
+    const int depth_;
+    const int maxIterations_;
+    std::vector<Node> nodes_;
+    std::vector<double> idf_;
+    int numWords_{0};
+    bool binary_{false};
+};
+
+}
+}
+
+#endif /* _VOCABULARY_TREE_H_ */
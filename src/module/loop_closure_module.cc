@@ -0,0 +1,339 @@
+#include "loop_closure_module.h"
+
+#include "feature/hamming_matcher.h"
+#include "util/tf_util.h"
+
+#include <chrono>
+
+using namespace std;
+
+namespace omni_slam
+{
+namespace module
+{
+
+LoopClosureModule::LoopClosureModule(std::unique_ptr<feature::Detector> &detector, std::unique_ptr<feature::BowDatabase> &database, std::unique_ptr<odometry::PNP> &pnp, std::unique_ptr<optimization::PoseGraph> &pose_graph, int num_candidates, int min_frame_gap, int min_inliers, int training_frames)
+    : detector_(std::move(detector)),
+    database_(std::move(database)),
+    pnp_(std::move(pnp)),
+    poseGraph_(std::move(pose_graph)),
+    numCandidates_(num_candidates),
+    minFrameGap_(min_frame_gap),
+    minInliers_(min_inliers),
+    trainingFrames_(training_frames)
+{
+    thread_ = std::thread(&LoopClosureModule::Run, this);
+}
+
+LoopClosureModule::LoopClosureModule(std::unique_ptr<feature::Detector> &&detector, std::unique_ptr<feature::BowDatabase> &&database, std::unique_ptr<odometry::PNP> &&pnp, std::unique_ptr<optimization::PoseGraph> &&pose_graph, int num_candidates, int min_frame_gap, int min_inliers, int training_frames)
+    : LoopClosureModule(detector, database, pnp, pose_graph, num_candidates, min_frame_gap, min_inliers, training_frames)
+{
+}
+
+LoopClosureModule::~LoopClosureModule()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    queueCondition_.notify_all();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+void LoopClosureModule::Update(const std::vector<data::Landmark> &landmarks, data::Frame &keyframe)
+{
+    if (!keyframe.HasEstimatedPose())
+    {
+        return;
+    }
+    // Only a snapshot crosses to the worker, the tracking thread keeps sole ownership of frames and landmarks
+    Keyframe snapshot;
+    snapshot.id = keyframe.GetID();
+    snapshot.prevId = lastKeyframeId_;
+    snapshot.inversePose = keyframe.GetEstimatedInversePose();
+    snapshot.odometry = lastKeyframeId_ >= 0 ? util::TFUtil::GetRelativeTransform(lastKeyframeInversePose_, keyframe.GetEstimatedInversePose()) : util::TFUtil::IdentityPoseMatrix<double>();
+    snapshot.cameraModel = &keyframe.GetCameraModel();
+    snapshot.image = keyframe.GetImage().clone();
+    for (const data::Landmark &landmark : landmarks)
+    {
+        if (!landmark.HasEstimatedPosition())
+        {
+            continue;
+        }
+        const data::Feature *feat = landmark.GetObservationByFrameID(keyframe.GetID());
+        if (feat == nullptr)
+        {
+            continue;
+        }
+        snapshot.keypoints.push_back(feat->GetKeypoint());
+        snapshot.points.push_back(landmark.GetEstimatedPosition());
+    }
+    lastKeyframeId_ = keyframe.GetID();
+    lastKeyframeInversePose_ = keyframe.GetEstimatedInversePose();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(snapshot));
+    }
+    queueCondition_.notify_one();
+}
+
+bool LoopClosureModule::ApplyCorrection(std::vector<std::unique_ptr<data::Frame>> &frames, std::vector<data::Landmark> &landmarks)
+{
+    std::map<int, Matrix<double, 3, 4>> corrections;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        corrections.swap(corrections_);
+    }
+    if (corrections.empty())
+    {
+        return false;
+    }
+
+    // Corrections are deltas from the snapshot poses, so refinements made since then survive, and frames keep
+    // their pose relative to the latest corrected keyframe, including ones tracked while the graph was solving
+    std::map<int, Matrix<double, 3, 4>> frameDeltas;
+    Matrix<double, 3, 4> delta;
+    bool hasDelta = false;
+    for (std::unique_ptr<data::Frame> &frame : frames)
+    {
+        if (!frame->HasEstimatedPose())
+        {
+            continue;
+        }
+        auto it = corrections.find(frame->GetID());
+        if (it != corrections.end())
+        {
+            delta = it->second;
+            hasDelta = true;
+        }
+        if (hasDelta)
+        {
+            frameDeltas[frame->GetID()] = delta;
+            frame->SetEstimatedInversePose(util::TFUtil::CombineTransforms(frame->GetEstimatedInversePose(), delta));
+        }
+    }
+    for (data::Landmark &landmark : landmarks)
+    {
+        if (!landmark.HasEstimatedPosition())
+        {
+            continue;
+        }
+        auto it = frameDeltas.find(landmark.GetFirstFrameID());
+        if (it == frameDeltas.end())
+        {
+            continue;
+        }
+        landmark.SetEstimatedPosition(util::TFUtil::TransformPoint(util::TFUtil::InversePoseMatrix(it->second), landmark.GetEstimatedPosition()));
+    }
+    auto lastIt = frameDeltas.find(lastKeyframeId_);
+    if (lastIt != frameDeltas.end())
+    {
+        lastKeyframeInversePose_ = util::TFUtil::CombineTransforms(lastKeyframeInversePose_, lastIt->second);
+    }
+    return true;
+}
+
+void LoopClosureModule::Finish()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idleCondition_.wait(lock, [this] { return queue_.empty() && !busy_; });
+}
+
+LoopClosureModule::Stats& LoopClosureModule::GetStats()
+{
+    return stats_;
+}
+
+void LoopClosureModule::Run()
+{
+    while (true)
+    {
+        Keyframe keyframe;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queueCondition_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (stop_)
+            {
+                return;
+            }
+            keyframe = std::move(queue_.front());
+            queue_.pop_front();
+            busy_ = true;
+        }
+        Process(keyframe);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busy_ = false;
+        }
+        idleCondition_.notify_all();
+    }
+}
+
+void LoopClosureModule::Process(Keyframe &keyframe)
+{
+    Describe(keyframe);
+
+    if (keyframe.prevId >= 0 && poseGraph_->HasNode(keyframe.prevId))
+    {
+        Matrix<double, 3, 4> prevPose;
+        poseGraph_->GetInversePose(keyframe.prevId, prevPose);
+        poseGraph_->AddNode(keyframe.id, util::TFUtil::CombineTransforms(keyframe.odometry, prevPose));
+        poseGraph_->AddEdge(keyframe.prevId, keyframe.id, keyframe.odometry);
+    }
+    else
+    {
+        poseGraph_->AddNode(keyframe.id, keyframe.inversePose);
+        if (firstKeyframeId_ < 0)
+        {
+            firstKeyframeId_ = keyframe.id;
+        }
+    }
+    keyframe.issuedInversePose = keyframe.inversePose;
+    keyframes_[keyframe.id] = keyframe;
+
+    feature::VocabularyTree &vocabulary = database_->GetVocabulary();
+    if (!vocabulary.IsTrained())
+    {
+        trainingIds_.push_back(keyframe.id);
+        if (trainingIds_.size() < trainingFrames_)
+        {
+            return;
+        }
+        vector<cv::Mat> trainingDescriptors;
+        for (int id : trainingIds_)
+        {
+            trainingDescriptors.push_back(keyframes_[id].descriptors);
+        }
+        vocabulary.Train(trainingDescriptors);
+        for (int id : trainingIds_)
+        {
+            database_->Add(id, keyframes_[id].descriptors);
+        }
+        trainingIds_.clear();
+        return;
+    }
+
+    vector<pair<int, double>> candidates;
+    if (keyframe.id - minFrameGap_ >= 0)
+    {
+        database_->Query(keyframe.descriptors, numCandidates_, candidates, keyframe.id - minFrameGap_);
+    }
+    database_->Add(keyframe.id, keyframe.descriptors);
+
+    for (pair<int, double> &candidate : candidates)
+    {
+        Matrix<double, 3, 4> relPose;
+        int numMatches;
+        int numInliers;
+        if (!Verify(keyframe, keyframes_.at(candidate.first), relPose, numMatches, numInliers))
+        {
+            continue;
+        }
+        poseGraph_->AddEdge(candidate.first, keyframe.id, relPose, true);
+        auto optStart = chrono::steady_clock::now();
+        bool success = poseGraph_->Optimize(firstKeyframeId_);
+        double optTime = chrono::duration<double>(chrono::steady_clock::now() - optStart).count();
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.loopClosures.emplace_back(vector<double>{(double)keyframe.id, (double)candidate.first, candidate.second, (double)numMatches, (double)numInliers});
+        stats_.optimizations.emplace_back(vector<double>{(double)keyframe.id, (double)poseGraph_->GetNumNodes(), (double)poseGraph_->GetNumEdges(), optTime, success ? 1. : 0.});
+        if (success)
+        {
+            // Each delta is relative to what the tracking thread was last told, and stacks onto any it has not applied yet
+            std::map<int, Matrix<double, 3, 4>> graphPoses;
+            poseGraph_->GetInversePoses(graphPoses);
+            for (auto &graphPose : graphPoses)
+            {
+                Keyframe &corrected = keyframes_.at(graphPose.first);
+                Matrix<double, 3, 4> delta = util::TFUtil::CombineTransforms(util::TFUtil::InversePoseMatrix(corrected.issuedInversePose), graphPose.second);
+                corrected.issuedInversePose = graphPose.second;
+                auto it = corrections_.find(graphPose.first);
+                corrections_[graphPose.first] = it != corrections_.end() ? util::TFUtil::CombineTransforms(it->second, delta) : delta;
+            }
+        }
+        break;
+    }
+}
+
+void LoopClosureModule::Describe(Keyframe &keyframe) const
+{
+    vector<cv::KeyPoint> kpts = keyframe.keypoints;
+    cv::Mat descs;
+    detector_->Describe(keyframe.image, kpts, descs);
+    keyframe.image.release();
+
+    // Extractors drop keypoints near the image border, so map survivors back to their map points
+    map<pair<float, float>, int> ptToIndex;
+    for (int i = 0; i < keyframe.keypoints.size(); i++)
+    {
+        ptToIndex[{keyframe.keypoints[i].pt.x, keyframe.keypoints[i].pt.y}] = i;
+    }
+    vector<cv::KeyPoint> keypoints;
+    vector<Vector3d> points;
+    cv::Mat descriptors;
+    keypoints.reserve(kpts.size());
+    points.reserve(kpts.size());
+    for (int i = 0; i < kpts.size(); i++)
+    {
+        auto it = ptToIndex.find({kpts[i].pt.x, kpts[i].pt.y});
+        if (it == ptToIndex.end())
+        {
+            continue;
+        }
+        keypoints.push_back(keyframe.keypoints[it->second]);
+        points.push_back(keyframe.points[it->second]);
+        descriptors.push_back(descs.row(i));
+    }
+    keyframe.keypoints = std::move(keypoints);
+    keyframe.points = std::move(points);
+    keyframe.descriptors = descriptors;
+}
+
+bool LoopClosureModule::Verify(const Keyframe &query, const Keyframe &candidate, Matrix<double, 3, 4> &rel_pose, int &num_matches, int &num_inliers) const
+{
+    num_matches = 0;
+    num_inliers = 0;
+    if (query.descriptors.empty() || candidate.descriptors.empty())
+    {
+        return false;
+    }
+    vector<cv::DMatch> matches;
+    if (query.descriptors.type() == CV_8U)
+    {
+        feature::HammingMatcher().Match(query.descriptors, candidate.descriptors, matches);
+    }
+    else
+    {
+        cv::BFMatcher(cv::NORM_L2, true).match(query.descriptors, candidate.descriptors, matches);
+    }
+    num_matches = matches.size();
+    if (num_matches < minInliers_)
+    {
+        return false;
+    }
+
+    // Candidate map points and the query observations give the query pose in the candidate's map frame
+    vector<Vector3d> xs;
+    vector<Vector2d> pixels;
+    xs.reserve(matches.size());
+    pixels.reserve(matches.size());
+    for (const cv::DMatch &match : matches)
+    {
+        xs.push_back(candidate.points[match.trainIdx]);
+        pixels.push_back(Vector2d(query.keypoints[match.queryIdx].pt.x, query.keypoints[match.queryIdx].pt.y));
+    }
+    Matrix<double, 3, 4> pose;
+    vector<int> inlierIndices;
+    num_inliers = pnp_->Compute(xs, pixels, *query.cameraModel, pose, inlierIndices);
+    if (num_inliers < minInliers_)
+    {
+        return false;
+    }
+    rel_pose = util::TFUtil::GetRelativeTransform(candidate.inversePose, pose);
+    return true;
+}
+
+}
+}
@@ -0,0 +1,97 @@
+#ifndef _LOOP_CLOSURE_MODULE_H_
+#define _LOOP_CLOSURE_MODULE_H_
+
+#include <vector>
+#include <map>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "feature/detector.h"
+#include "feature/bow_database.h"
+#include "odometry/pnp.h"
+#include "optimization/pose_graph.h"
+#include "data/frame.h"
+#include "data/landmark.h"
+
+using namespace Eigen;
+
+namespace omni_slam
+{
+namespace module
+{
+
+class LoopClosureModule
+{
+public:
+    struct Stats
+    {
+        std::vector<std::vector<double>> loopClosures;
+        std::vector<std::vector<double>> optimizations;
+    };
+
+    LoopClosureModule(std::unique_ptr<feature::Detector> &detector, std::unique_ptr<feature::BowDatabase> &database, std::unique_ptr<odometry::PNP> &pnp, std::unique_ptr<optimization::PoseGraph> &pose_graph, int num_candidates = 3, int min_frame_gap = 50, int min_inliers = 30, int training_frames = 10);
+    LoopClosureModule(std::unique_ptr<feature::Detector> &&detector, std::unique_ptr<feature::BowDatabase> &&database, std::unique_ptr<odometry::PNP> &&pnp, std::unique_ptr<optimization::PoseGraph> &&pose_graph, int num_candidates = 3, int min_frame_gap = 50, int min_inliers = 30, int training_frames = 10);
+    ~LoopClosureModule();
+
+    void Update(const std::vector<data::Landmark> &landmarks, data::Frame &keyframe);
+    bool ApplyCorrection(std::vector<std::unique_ptr<data::Frame>> &frames, std::vector<data::Landmark> &landmarks);
+    void Finish();
+
+    Stats& GetStats();
+
+private:
+    struct Keyframe
+    {
+        int id;
+        int prevId;
+        Matrix<double, 3, 4> inversePose;
+        Matrix<double, 3, 4> issuedInversePose;
+        Matrix<double, 3, 4> odometry;
+        const camera::CameraModel<> *cameraModel;
+        cv::Mat image;
+        std::vector<cv::KeyPoint> keypoints;
+        std::vector<Vector3d> points;
+        cv::Mat descriptors;
+    };
+
+    void Run();
+    void Process(Keyframe &keyframe);
+    void Describe(Keyframe &keyframe) const;
+    bool Verify(const Keyframe &query, const Keyframe &candidate, Matrix<double, 3, 4> &rel_pose, int &num_matches, int &num_inliers) const;
+
+    std::shared_ptr<feature::Detector> detector_;
+    std::shared_ptr<feature::BowDatabase> database_;
+    std::shared_ptr<odometry::PNP> pnp_;
+    std::shared_ptr<optimization::PoseGraph> poseGraph_;
+
+    int numCandidates_;
+    int minFrameGap_;
+    int minInliers_;
+    int trainingFrames_;
+
+    int lastKeyframeId_{-1};
+    Matrix<double, 3, 4> lastKeyframeInversePose_;
+
+    std::map<int, Keyframe> keyframes_;
+    std::vector<int> trainingIds_;
+    int firstKeyframeId_{-1};
+
+    std::deque<Keyframe> queue_;
+    std::map<int, Matrix<double, 3, 4>> corrections_;
+    bool busy_{false};
+    bool stop_{false};
+    std::mutex mutex_;
+    std::condition_variable queueCondition_;
+    std::condition_variable idleCondition_;
+    std::thread thread_;
+
+    Stats stats_;
+};
+
+}
+}
+
+#endif /* _LOOP_CLOSURE_MODULE_H_ */
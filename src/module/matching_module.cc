@@ -1,6 +1,9 @@
 #include "matching_module.h"
 
 #include "util/tf_util.h"
+#include <chrono>
+#include <set>
+#include <tuple>
 
 using namespace std;
 
@@ -9,18 +12,36 @@ namespace omni_slam
 namespace module
 {
 
-MatchingModule::MatchingModule(std::unique_ptr<feature::Detector> &detector, std::unique_ptr<feature::Matcher> &matcher, std::unique_ptr<odometry::FivePoint> &estimator, double overlap_thresh, double dist_thresh)
+MatchingModule::MatchingModule(std::unique_ptr<feature::Detector> &detector, std::unique_ptr<feature::Matcher> &matcher, std::unique_ptr<odometry::FivePoint> &estimator, double overlap_thresh, double dist_thresh, bool benchmark_exact, bool benchmark_hamming)
     : detector_(std::move(detector)),
     matcher_(std::move(matcher)),
     fivePointEstimator_(std::move(estimator)),
     overlapThresh_(overlap_thresh),
-    distThresh_(dist_thresh)
+    distThresh_(dist_thresh),
+    benchmarkExact_(benchmark_exact),
+    benchmarkHamming_(benchmark_hamming)
 {
+    if (detector_)
+    {
+        detectorPool_.reset(new feature::DetectorPool(*detector_));
+    }
+}
+
+MatchingModule::MatchingModule(std::unique_ptr<feature::Detector> &&detector, std::unique_ptr<feature::Matcher> &&matcher, std::unique_ptr<odometry::FivePoint> &&estimator, double overlap_thresh, double dist_thresh, bool benchmark_exact, bool benchmark_hamming)
+    : MatchingModule(detector, matcher, estimator, overlap_thresh, dist_thresh, benchmark_exact, benchmark_hamming)
+{
+}
+
+void MatchingModule::SetPlaceRecognition(std::unique_ptr<feature::BowDatabase> &database, int num_candidates, int training_frames)
+{
+    bowDatabase_ = std::move(database);
+    bowNumCandidates_ = num_candidates;
+    bowTrainingFrames_ = training_frames;
 }
 
-MatchingModule::MatchingModule(std::unique_ptr<feature::Detector> &&detector, std::unique_ptr<feature::Matcher> &&matcher, std::unique_ptr<odometry::FivePoint> &&estimator, double overlap_thresh, double dist_thresh)
-    : MatchingModule(detector, matcher, estimator, overlap_thresh, dist_thresh)
+void MatchingModule::SetPlaceRecognition(std::unique_ptr<feature::BowDatabase> &&database, int num_candidates, int training_frames)
 {
+    SetPlaceRecognition(database, num_candidates, training_frames);
 }
 
 void MatchingModule::Update(std::unique_ptr<data::Frame> &frame)
@@ -30,15 +51,22 @@ void MatchingModule::Update(std::unique_ptr<data::Frame> &frame)
 
     vector<data::Landmark> curLandmarks;
     int imsize = max(frames_.back()->GetImage().rows, frames_.back()->GetImage().cols);
+    int numRegions = (feature::Region::rs.size() - 1) * (feature::Region::ts.size() - 1);
+    vector<vector<cv::KeyPoint>> regionKpts(numRegions);
+    vector<cv::Mat> regionDescs(numRegions);
     #pragma omp parallel for collapse(2)
     for (int i = 0; i < feature::Region::rs.size() - 1; i++)
     {
         for (int j = 0; j < feature::Region::ts.size() - 1; j++)
         {
-            feature::Detector detector(*detector_);
-            detector.DetectInRadialRegion(*frames_.back(), curLandmarks, feature::Region::rs[i] * imsize, feature::Region::rs[i+1] * imsize, feature::Region::ts[j], feature::Region::ts[j+1]);
+            int r = i * (feature::Region::ts.size() - 1) + j;
+            detectorPool_->Get().DetectInRadialRegion(*frames_.back(), regionKpts[r], regionDescs[r], feature::Region::rs[i] * imsize, feature::Region::rs[i+1] * imsize, feature::Region::ts[j], feature::Region::ts[j+1]);
         }
     }
+    feature::Detector::AddLandmarks(*frames_.back(), curLandmarks, regionKpts, regionDescs);
+
+    set<int> candidateIds;
+    bool pruneCandidates = bowDatabase_ && QueryCandidates(*frames_.back(), candidateIds);
 
     if (frameNum_ == 0)
     {
@@ -55,15 +83,73 @@ void MatchingModule::Update(std::unique_ptr<data::Frame> &frame)
     if (frameNum_ == 0)
     {
         landmarks_ = std::move(curLandmarks);
+        matcher_->Index(landmarks_);
         frames_.back()->CompressImages();
         frameNum_++;
         return;
     }
 
+    if (pruneCandidates)
+    {
+        // All train landmarks come from the first frame, so retrieval decides whether this frame is matched at all
+        bool retrieved = candidateIds.find(frames_.front()->GetID()) != candidateIds.end();
+        stats_.bowRetrievals.emplace_back(vector<double>{(double)frameNum_, retrieved ? 1. : 0.});
+        if (!retrieved)
+        {
+            frames_.back()->CompressImages();
+            frameNum_++;
+            return;
+        }
+    }
+
     vector<data::Landmark> matches;
     vector<vector<double>> distances;
+    vector<vector<double>> secondDistances;
     vector<int> indices;
-    map<pair<int, int>, int> numMatches = matcher_->Match(landmarks_, curLandmarks, matches, distances, indices);
+    auto matchStart = chrono::steady_clock::now();
+    map<pair<int, int>, int> numMatches = matcher_->Match(landmarks_, curLandmarks, matches, distances, secondDistances, indices);
+    double matchTime = chrono::duration<double>(chrono::steady_clock::now() - matchStart).count();
+    stats_.frameMatchTimes.emplace_back(vector<double>{(double)frameNum_, matchTime});
+    if (benchmarkExact_ && matcher_->IsApproximate())
+    {
+        vector<data::Landmark> exactMatches;
+        vector<vector<double>> exactDistances;
+        vector<int> exactIndices;
+        matcher_->SetApproximate(false);
+        auto exactStart = chrono::steady_clock::now();
+        matcher_->Match(landmarks_, curLandmarks, exactMatches, exactDistances, exactIndices);
+        double exactTime = chrono::duration<double>(chrono::steady_clock::now() - exactStart).count();
+        matcher_->SetApproximate(true);
+        set<tuple<int, int, float, float>> approxPairs;
+        for (int i = 0; i < matches.size(); i++)
+        {
+            for (int j = 1; j < matches[i].GetNumObservations(); j++)
+            {
+                const data::Feature &trainFeat = matches[i].GetObservations()[j];
+                approxPairs.insert(make_tuple(indices[i], trainFeat.GetFrame().GetID(), trainFeat.GetKeypoint().pt.x, trainFeat.GetKeypoint().pt.y));
+            }
+        }
+        int numExact = 0;
+        int numRecalled = 0;
+        for (int i = 0; i < exactMatches.size(); i++)
+        {
+            for (int j = 1; j < exactMatches[i].GetNumObservations(); j++)
+            {
+                const data::Feature &trainFeat = exactMatches[i].GetObservations()[j];
+                numExact++;
+                if (approxPairs.find(make_tuple(exactIndices[i], trainFeat.GetFrame().GetID(), trainFeat.GetKeypoint().pt.x, trainFeat.GetKeypoint().pt.y)) != approxPairs.end())
+                {
+                    numRecalled++;
+                }
+            }
+        }
+        stats_.approximateMatchBenchmarks.emplace_back(vector<double>{(double)frameNum_, matchTime, exactTime, numExact > 0 ? (double)numRecalled / numExact : 1.});
+    }
+
+    if (benchmarkHamming_)
+    {
+        BenchmarkHamming(frames_.front()->GetDescriptors(), frames_.back()->GetDescriptors());
+    }
 
     for (int i = 0; i < frames_.size() - 1; i++)
     {
@@ -94,6 +180,12 @@ void MatchingModule::Update(std::unique_ptr<data::Frame> &frame)
             Vector2d curPix;
             curPix << curFeat.GetKeypoint().pt.x, curFeat.GetKeypoint().pt.y;
             double descDist = distances[std::distance(matches.begin(), it)][i - 1];
+            if (matcher_->IsRatioTest())
+            {
+                // Score by Lowe ratio so the curves sweep the ratio threshold instead of the absolute distance
+                double secondDist = secondDistances[std::distance(matches.begin(), it)][i - 1];
+                descDist = secondDist > 0 ? descDist / secondDist : 1.;
+            }
             double x = curPix(0) - frames_.back()->GetImage().cols / 2. + 0.5;
             double y = curPix(1) - frames_.back()->GetImage().rows / 2. + 0.5;
             double r = sqrt(x * x + y * y) / imsize;
@@ -299,6 +391,83 @@ void MatchingModule::Update(std::unique_ptr<data::Frame> &frame)
     frameNum_++;
 }
 
+void MatchingModule::BenchmarkHamming(const cv::Mat &train, const cv::Mat &query)
+{
+    if (train.empty() || query.empty() || train.type() != CV_8U || query.type() != CV_8U)
+    {
+        return;
+    }
+    const bool crossCheck = !matcher_->IsRatioTest();
+    feature::HammingMatcher hammingMatcher(crossCheck);
+    vector<cv::DMatch> nativeMatches;
+    auto nativeStart = chrono::steady_clock::now();
+    hammingMatcher.Match(query, train, nativeMatches);
+    double nativeTime = chrono::duration<double>(chrono::steady_clock::now() - nativeStart).count();
+
+    cv::BFMatcher cvMatcher(cv::NORM_HAMMING, crossCheck);
+    vector<cv::DMatch> cvMatches;
+    auto cvStart = chrono::steady_clock::now();
+    cvMatcher.match(query, train, cvMatches);
+    double cvTime = chrono::duration<double>(chrono::steady_clock::now() - cvStart).count();
+
+    // Ties may resolve to different train rows, so agreement is measured on distances
+    map<int, float> cvDistances;
+    for (const cv::DMatch &match : cvMatches)
+    {
+        cvDistances[match.queryIdx] = match.distance;
+    }
+    int numAgree = 0;
+    for (const cv::DMatch &match : nativeMatches)
+    {
+        auto it = cvDistances.find(match.queryIdx);
+        if (it != cvDistances.end() && it->second == match.distance)
+        {
+            numAgree++;
+        }
+    }
+    int numTotal = max(nativeMatches.size(), cvMatches.size());
+    stats_.hammingMatchBenchmarks.emplace_back(vector<double>{(double)frameNum_, (double)query.rows, (double)train.rows, nativeTime, cvTime, numTotal > 0 ? (double)numAgree / numTotal : 1., (double)feature::HammingMatcher::GetKernelLevel()});
+}
+
+bool MatchingModule::QueryCandidates(data::Frame &frame, set<int> &candidate_ids)
+{
+    feature::VocabularyTree &vocabulary = bowDatabase_->GetVocabulary();
+    const cv::Mat &descriptors = frame.GetDescriptors();
+    if (!vocabulary.IsTrained())
+    {
+        bowTrainingSet_.emplace_back(frame.GetID(), descriptors);
+        if (bowTrainingSet_.size() < bowTrainingFrames_)
+        {
+            return false;
+        }
+        vector<cv::Mat> trainingDescriptors;
+        for (auto &entry : bowTrainingSet_)
+        {
+            trainingDescriptors.push_back(entry.second);
+        }
+        vocabulary.Train(trainingDescriptors);
+        for (auto &entry : bowTrainingSet_)
+        {
+            bowDatabase_->Add(entry.first, entry.second);
+        }
+        bowTrainingSet_.clear();
+        return false;
+    }
+
+    vector<pair<int, double>> results;
+    auto queryStart = chrono::steady_clock::now();
+    bowDatabase_->Query(descriptors, bowNumCandidates_, results);
+    double queryTime = chrono::duration<double>(chrono::steady_clock::now() - queryStart).count();
+    bowDatabase_->Add(frame.GetID(), descriptors);
+    stats_.bowQueryTimes.emplace_back(vector<double>{(double)frameNum_, queryTime});
+    for (auto &result : results)
+    {
+        candidate_ids.insert(result.first);
+        stats_.bowCandidates.emplace_back(vector<double>{(double)frameNum_, (double)frameIdToNum_[result.first], result.second});
+    }
+    return true;
+}
+
 MatchingModule::Stats& MatchingModule::GetStats()
 {
     return stats_;
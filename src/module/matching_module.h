@@ -4,10 +4,14 @@
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include <memory>
+#include <set>
 
 #include "feature/matcher.h"
+#include "feature/hamming_matcher.h"
 #include "feature/detector.h"
+#include "feature/detector_pool.h"
 #include "feature/region.h"
+#include "feature/bow_database.h"
 #include "odometry/five_point.h"
 #include "data/frame.h"
 #include "data/landmark.h"
@@ -31,10 +35,19 @@ public:
         std::vector<std::vector<double>> goodDeltaBearings;
         std::vector<std::vector<double>> badDeltaBearings;
         std::vector<std::vector<double>> rotationErrors;
+        std::vector<std::vector<double>> frameMatchTimes;
+        std::vector<std::vector<double>> approximateMatchBenchmarks;
+        std::vector<std::vector<double>> hammingMatchBenchmarks;
+        std::vector<std::vector<double>> bowCandidates;
+        std::vector<std::vector<double>> bowQueryTimes;
+        std::vector<std::vector<double>> bowRetrievals;
     };
 
-    MatchingModule(std::unique_ptr<feature::Detector> &detector, std::unique_ptr<feature::Matcher> &matcher, std::unique_ptr<odometry::FivePoint> &estimator, double overlap_thresh = 0.5, double dist_thresh = 10.);
-    MatchingModule(std::unique_ptr<feature::Detector> &&detector, std::unique_ptr<feature::Matcher> &&matcher, std::unique_ptr<odometry::FivePoint> &&estimator, double overlap_thresh = 0.5, double dist_thresh = 10.);
+    MatchingModule(std::unique_ptr<feature::Detector> &detector, std::unique_ptr<feature::Matcher> &matcher, std::unique_ptr<odometry::FivePoint> &estimator, double overlap_thresh = 0.5, double dist_thresh = 10., bool benchmark_exact = false, bool benchmark_hamming = false);
+    MatchingModule(std::unique_ptr<feature::Detector> &&detector, std::unique_ptr<feature::Matcher> &&matcher, std::unique_ptr<odometry::FivePoint> &&estimator, double overlap_thresh = 0.5, double dist_thresh = 10., bool benchmark_exact = false, bool benchmark_hamming = false);
+
+    void SetPlaceRecognition(std::unique_ptr<feature::BowDatabase> &database, int num_candidates, int training_frames);
+    void SetPlaceRecognition(std::unique_ptr<feature::BowDatabase> &&database, int num_candidates, int training_frames);
 
     void Update(std::unique_ptr<data::Frame> &frame);
 
@@ -57,15 +70,25 @@ private:
         cv::Mat curMask_;
     };
 
+    bool QueryCandidates(data::Frame &frame, std::set<int> &candidate_ids);
+    void BenchmarkHamming(const cv::Mat &train, const cv::Mat &query);
+
     std::shared_ptr<feature::Detector> detector_;
+    std::shared_ptr<feature::DetectorPool> detectorPool_;
     std::shared_ptr<feature::Matcher> matcher_;
     std::shared_ptr<odometry::FivePoint> fivePointEstimator_;
+    std::shared_ptr<feature::BowDatabase> bowDatabase_;
 
     std::vector<std::unique_ptr<data::Frame>> frames_;
     std::vector<data::Landmark> landmarks_;
 
     double overlapThresh_;
     double distThresh_;
+    bool benchmarkExact_;
+    bool benchmarkHamming_;
+    int bowNumCandidates_{0};
+    int bowTrainingFrames_{0};
+    std::vector<std::pair<int, cv::Mat>> bowTrainingSet_;
 
     int frameNum_{0};
     std::unordered_map<int, int> frameIdToNum_;
@@ -7,26 +7,62 @@ namespace omni_slam
 namespace module
 {
 
-OdometryModule::OdometryModule(std::unique_ptr<odometry::PoseEstimator> &pose_estimator, std::unique_ptr<optimization::BundleAdjuster> &bundle_adjuster)
+OdometryModule::OdometryModule(std::unique_ptr<odometry::PoseEstimator> &pose_estimator, std::unique_ptr<optimization::BundleAdjuster> &bundle_adjuster, bool use_motion_model)
     : poseEstimator_(std::move(pose_estimator)),
-    bundleAdjuster_(std::move(bundle_adjuster))
+    bundleAdjuster_(std::move(bundle_adjuster)),
+    useMotionModel_(use_motion_model)
 {
 }
 
-OdometryModule::OdometryModule(std::unique_ptr<odometry::PoseEstimator> &&pose_estimator, std::unique_ptr<optimization::BundleAdjuster> &&bundle_adjuster)
-    : OdometryModule(pose_estimator, bundle_adjuster)
+OdometryModule::OdometryModule(std::unique_ptr<odometry::PoseEstimator> &&pose_estimator, std::unique_ptr<optimization::BundleAdjuster> &&bundle_adjuster, bool use_motion_model)
+    : OdometryModule(pose_estimator, bundle_adjuster, use_motion_model)
 {
 }
 
+void OdometryModule::PredictPose(data::Frame &frame)
+{
+    if (!useMotionModel_)
+    {
+        return;
+    }
+    Matrix<double, 3, 4> pose;
+    if (motionModel_.Predict(frame.GetTime(), pose))
+    {
+        frame.SetPredictedPose(pose);
+    }
+}
+
 void OdometryModule::Update(std::vector<data::Landmark> &landmarks, std::unique_ptr<data::Frame> &cur_frame, const data::Frame *keyframe)
 {
     if (landmarks.size() == 0)
     {
+        if (frameNum_ == 0 && cur_frame->HasPose())
+        {
+            motionModel_.Update(cur_frame->GetPose(), cur_frame->GetTime());
+        }
         frameNum_++;
         return;
     }
     vector<int> inliers;
+    int numGuided = poseEstimator_->GetNumGuidedEstimates();
+    int numRANSAC = poseEstimator_->GetNumRANSACEstimates();
     poseEstimator_->Compute(landmarks, *cur_frame, *keyframe, inliers);
+    if (poseEstimator_->GetNumGuidedEstimates() > numGuided)
+    {
+        stats_.estimationPaths.push_back(std::vector<double>{(double)frameNum_, 1});
+    }
+    else if (poseEstimator_->GetNumRANSACEstimates() > numRANSAC)
+    {
+        stats_.estimationPaths.push_back(std::vector<double>{(double)frameNum_, 0});
+    }
+    if (cur_frame->HasEstimatedPose())
+    {
+        motionModel_.Update(cur_frame->GetEstimatedPose(), cur_frame->GetTime());
+    }
+    else
+    {
+        motionModel_.Reset();
+    }
 
     unordered_set<int> inlierSet(inliers.begin(), inliers.end());
     int imsize = max(cur_frame->GetImage().rows, cur_frame->GetImage().cols);
@@ -57,6 +93,18 @@ void OdometryModule::BundleAdjust(std::vector<data::Landmark> &landmarks)
     bundleAdjuster_->Optimize(landmarks);
 }
 
+void OdometryModule::ApplyCorrection(const data::Frame &last_frame)
+{
+    if (last_frame.HasEstimatedPose())
+    {
+        motionModel_.Rebase(last_frame.GetEstimatedPose());
+    }
+    else
+    {
+        motionModel_.Reset();
+    }
+}
+
 OdometryModule::Stats& OdometryModule::GetStats()
 {
     return stats_;
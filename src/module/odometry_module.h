@@ -6,6 +6,7 @@
 #include <memory>
 
 #include "odometry/pose_estimator.h"
+#include "odometry/motion_model.h"
 #include "optimization/bundle_adjuster.h"
 #include "data/landmark.h"
 
@@ -26,22 +27,28 @@ public:
     {
         std::vector<std::vector<double>> inlierRadDists;
         std::vector<std::vector<double>> outlierRadDists;
+        std::vector<std::vector<double>> estimationPaths;
     };
 
-    OdometryModule(std::unique_ptr<odometry::PoseEstimator> &pose_estimator, std::unique_ptr<optimization::BundleAdjuster> &bundle_adjuster);
-    OdometryModule(std::unique_ptr<odometry::PoseEstimator> &&pose_estimator, std::unique_ptr<optimization::BundleAdjuster> &&bundle_adjuster);
+    OdometryModule(std::unique_ptr<odometry::PoseEstimator> &pose_estimator, std::unique_ptr<optimization::BundleAdjuster> &bundle_adjuster, bool use_motion_model = false);
+    OdometryModule(std::unique_ptr<odometry::PoseEstimator> &&pose_estimator, std::unique_ptr<optimization::BundleAdjuster> &&bundle_adjuster, bool use_motion_model = false);
 
+    void PredictPose(data::Frame &frame);
     void Update(std::vector<data::Landmark> &landmarks, std::unique_ptr<data::Frame> &cur_frame, const data::Frame *keyframe);
     void BundleAdjust(std::vector<data::Landmark> &landmarks);
+    void ApplyCorrection(const data::Frame &last_frame);
 
     Stats& GetStats();
 
 private:
     std::shared_ptr<odometry::PoseEstimator> poseEstimator_;
     std::shared_ptr<optimization::BundleAdjuster> bundleAdjuster_;
+    odometry::MotionModel motionModel_;
 
     Stats stats_;
 
+    bool useMotionModel_;
+
     int frameNum_{0};
 };
 
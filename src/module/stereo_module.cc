@@ -1,6 +1,7 @@
 #include "stereo_module.h"
 
 #include <algorithm>
+#include <chrono>
 
 using namespace std;
 
@@ -21,7 +22,9 @@ StereoModule::StereoModule(std::unique_ptr<stereo::StereoMatcher> &&stereo)
 
 void StereoModule::Update(data::Frame &frame, std::vector<data::Landmark> &landmarks)
 {
-    stereo_->Match(frame, landmarks);
+    auto matchStart = chrono::steady_clock::now();
+    int numMatches = stereo_->Match(frame, landmarks);
+    stats_.frameMatchTimes.emplace_back(vector<double>{(double)frameNum_, chrono::duration<double>(chrono::steady_clock::now() - matchStart).count(), (double)numMatches});
 
     if (frameNum_ == 0)
     {
@@ -24,6 +24,7 @@ public:
     struct Stats
     {
         std::vector<std::vector<double>> depthErrRadDists;
+        std::vector<std::vector<double>> frameMatchTimes;
     };
 
     StereoModule(std::unique_ptr<stereo::StereoMatcher> &stereo);
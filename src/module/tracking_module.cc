@@ -3,6 +3,7 @@
 #include "util/tf_util.h"
 #include "util/math_util.h"
 #include <omp.h>
+#include <chrono>
 
 using namespace std;
 
@@ -11,17 +12,25 @@ namespace omni_slam
 namespace module
 {
 
-TrackingModule::TrackingModule(std::unique_ptr<feature::Detector> &detector, std::unique_ptr<feature::Tracker> &tracker, std::unique_ptr<odometry::FivePoint> &checker, int minFeaturesRegion, int maxFeaturesRegion)
+TrackingModule::TrackingModule(std::unique_ptr<feature::Detector> &detector, std::unique_ptr<feature::Tracker> &tracker, std::unique_ptr<odometry::FivePoint> &checker, int minFeaturesRegion, int maxFeaturesRegion, double suppressionRadius, bool adaptiveThresholds)
     : detector_(std::move(detector)),
     tracker_(std::move(tracker)),
     fivePointChecker_(std::move(checker)),
     minFeaturesRegion_(minFeaturesRegion),
-    maxFeaturesRegion_(maxFeaturesRegion)
+    maxFeaturesRegion_(maxFeaturesRegion),
+    suppressionRadius_(suppressionRadius),
+    adaptiveThresholds_(false)
 {
+    if (detector_)
+    {
+        detectorPool_.reset(new feature::DetectorPool(*detector_));
+        adaptiveThresholds_ = adaptiveThresholds && detector_->GetThreshold(baseThreshold_);
+        integralThreshold_ = detector_->IsThresholdIntegral();
+    }
 }
 
-TrackingModule::TrackingModule(std::unique_ptr<feature::Detector> &&detector, std::unique_ptr<feature::Tracker> &&tracker, std::unique_ptr<odometry::FivePoint> &&checker, int minFeaturesRegion, int maxFeaturesRegion)
-    : TrackingModule(detector, tracker, checker, minFeaturesRegion, maxFeaturesRegion)
+TrackingModule::TrackingModule(std::unique_ptr<feature::Detector> &&detector, std::unique_ptr<feature::Tracker> &&tracker, std::unique_ptr<odometry::FivePoint> &&checker, int minFeaturesRegion, int maxFeaturesRegion, double suppressionRadius, bool adaptiveThresholds)
+    : TrackingModule(detector, tracker, checker, minFeaturesRegion, maxFeaturesRegion, suppressionRadius, adaptiveThresholds)
 {
 }
 
@@ -37,13 +46,26 @@ void TrackingModule::Update(std::unique_ptr<data::Frame> &frame)
 
         visualization_.Init(frames_.back()->GetImage().size(), landmarks_.size());
 
+        stats_.keyframes.push_back(frameNum_);
         frameNum_++;
         return;
     }
 
     lastKeyframe_ = tracker_->GetLastKeyframe();
     vector<double> trackErrors;
+    auto trackStart = chrono::steady_clock::now();
     int tracks = tracker_->Track(landmarks_, *frames_.back(), trackErrors);
+    stats_.frameTrackTimes.push_back({(double)frameNum_, chrono::duration<double>(chrono::steady_clock::now() - trackStart).count()});
+    if (!tracker_->GetLastKernelBenchmark().empty())
+    {
+        stats_.kernelBenchmarks.push_back({(double)frameNum_});
+        stats_.kernelBenchmarks.back().insert(stats_.kernelBenchmarks.back().end(), tracker_->GetLastKernelBenchmark().begin(), tracker_->GetLastKernelBenchmark().end());
+    }
+    if (tracker_->GetLastKeyframe() == frames_.back().get())
+    {
+        stats_.keyframes.push_back(frameNum_);
+    }
+    int fivePointRejected = 0;
     if (fivePointChecker_ && tracks > 0)
     {
         Matrix3d E;
@@ -55,6 +77,7 @@ void TrackingModule::Update(std::unique_ptr<data::Frame> &frame)
             if (landmarks_[i].IsObservedInFrame(frames_.back()->GetID()) && inlierSet.find(i) == inlierSet.end())
             {
                 landmarks_[i].RemoveLastObservation();
+                fivePointRejected++;
             }
         }
         if (frames_.back()->HasStereoImage())
@@ -73,6 +96,8 @@ void TrackingModule::Update(std::unique_ptr<data::Frame> &frame)
         }
     }
 
+    stats_.frameRejectedCounts.push_back({frameNum_, tracker_->GetLastRejectedCount(), fivePointRejected});
+
     int i = 0;
     int numGood = 0;
     regionCount_.clear();
@@ -159,7 +184,7 @@ void TrackingModule::Update(std::unique_ptr<data::Frame> &frame)
         else
         {
             const data::Feature *obs = landmark.GetObservationByFrameID(lastKeyframe_->GetID());
-            if (obs != nullptr) // Failed in current frame
+            if (obs != nullptr && !landmark.IsTerminated()) // Failed in current frame
             {
 
                 Vector2d pixelGnd;
@@ -179,6 +204,15 @@ void TrackingModule::Update(std::unique_ptr<data::Frame> &frame)
     stats_.frameTrackCounts.emplace_back(vector<int>{frameNum_, numGood});
 
     Prune();
+    int numLive = 0;
+    for (const data::Landmark &landmark : landmarks_)
+    {
+        if (!landmark.IsTerminated() && landmark.IsObservedInFrame(frames_.back()->GetID()))
+        {
+            numLive++;
+        }
+    }
+    stats_.frameLandmarkCounts.emplace_back(vector<int>{frameNum_, numLive, numPruned_});
 
     (*next(frames_.rbegin()))->CompressImages();
 
@@ -192,40 +226,104 @@ void TrackingModule::Redetect()
         return;
     }
     int imsize = max(frames_.back()->GetImage().rows, frames_.back()->GetImage().cols);
+    cv::Mat freeMask;
+    if (suppressionRadius_ > 0)
+    {
+        data::Frame &frame = *frames_.back();
+        const camera::CameraModel<> &cam = frame.GetCameraModel();
+        freeMask = cv::Mat(frame.GetImage().size(), CV_8U, cv::Scalar(255));
+        double centerRes = cam.GetAngularResolution(Vector2d(freeMask.cols / 2., freeMask.rows / 2.));
+        for (const data::Landmark &landmark : landmarks_)
+        {
+            const data::Feature *obs = landmark.GetObservationByFrameID(frame.GetID());
+            if (obs == nullptr)
+            {
+                continue;
+            }
+            const cv::Point2f &pt = obs->GetKeypoint().pt;
+            double res = cam.GetAngularResolution(Vector2d(pt.x, pt.y));
+            double radius = (res > 0 && centerRes > 0) ? suppressionRadius_ * centerRes / res : suppressionRadius_;
+            cv::circle(freeMask, pt, max(1, (int)round(radius)), cv::Scalar(0), -1);
+        }
+    }
+    int numRegions = (feature::Region::rs.size() - 1) * (feature::Region::ts.size() - 1);
+    vector<vector<cv::KeyPoint>> regionKpts(numRegions);
+    vector<cv::Mat> regionDescs(numRegions);
+    if (adaptiveThresholds_ && regionThresholds_.size() != numRegions)
+    {
+        regionThresholds_.assign(numRegions, baseThreshold_);
+    }
     #pragma omp parallel for collapse(2)
     for (int i = 0; i < feature::Region::rs.size() - 1; i++)
     {
         for (int j = 0; j < feature::Region::ts.size() - 1; j++)
         {
-            if (regionCount_.find({i, j}) == regionCount_.end() || regionCount_.at({i, j}) < minFeaturesRegion_)
+            int count = regionCount_.find({i, j}) == regionCount_.end() ? 0 : regionCount_.at({i, j});
+            if (count < minFeaturesRegion_)
             {
-                detector_->DetectInRadialRegion(*frames_.back(), landmarks_, feature::Region::rs[i] * imsize, feature::Region::rs[i+1] * imsize, feature::Region::ts[j], feature::Region::ts[j+1]);
+                int r = i * (feature::Region::ts.size() - 1) + j;
+                feature::Detector &detector = detectorPool_->Get();
+                if (!adaptiveThresholds_)
+                {
+                    detector.DetectInRadialRegion(*frames_.back(), regionKpts[r], regionDescs[r], feature::Region::rs[i] * imsize, feature::Region::rs[i+1] * imsize, feature::Region::ts[j], feature::Region::ts[j+1], false, freeMask);
+                    continue;
+                }
+                int budget = maxFeaturesRegion_ - count;
+                detector.SetThreshold(regionThresholds_[r]);
+                detector.SetMaxFeatures(budget);
+                int yield = detector.DetectInRadialRegion(*frames_.back(), regionKpts[r], regionDescs[r], feature::Region::rs[i] * imsize, feature::Region::rs[i+1] * imsize, feature::Region::ts[j], feature::Region::ts[j+1], false, freeMask);
+                // A saturated budget means the threshold let through more than was kept; a shortfall means it was too strict
+                // Integral thresholds are rounded when applied, so they move by at least one unit per step
+                if (yield >= budget)
+                {
+                    double next = regionThresholds_[r] * thresholdStep_;
+                    if (integralThreshold_)
+                    {
+                        next = max(next, round(regionThresholds_[r]) + 1);
+                    }
+                    regionThresholds_[r] = min(next, baseThreshold_ * thresholdRange_);
+                }
+                else if (yield < minFeaturesRegion_ - count)
+                {
+                    double next = regionThresholds_[r] / thresholdStep_;
+                    if (integralThreshold_)
+                    {
+                        next = min(next, round(regionThresholds_[r]) - 1);
+                    }
+                    regionThresholds_[r] = max(next, max(baseThreshold_ / thresholdRange_, integralThreshold_ ? min(1., baseThreshold_) : 0.));
+                }
             }
         }
     }
+    feature::Detector::AddLandmarks(*frames_.back(), landmarks_, regionKpts, regionDescs);
 }
 
 void TrackingModule::Prune()
 {
-    #pragma omp parallel for collapse(2)
+    int numPruned = 0;
+    #pragma omp parallel for collapse(2) reduction(+:numPruned)
     for (int i = 0; i < feature::Region::rs.size() - 1; i++)
     {
         for (int j = 0; j < feature::Region::ts.size() - 1; j++)
         {
             if (regionCount_.find({i, j}) != regionCount_.end() && regionCount_.at({i, j}) > maxFeaturesRegion_)
             {
+                // Termination is permanent, so the shortest tracks are retired and the long, well-conditioned ones kept
                 sort(regionLandmarks_.at({i, j}).begin(), regionLandmarks_.at({i, j}).end(),
                         [](const data::Landmark *a, const data::Landmark *b) -> bool
                         {
-                            return a->GetNumObservations() > b->GetNumObservations();
+                            return a->GetNumObservations() < b->GetNumObservations();
                         });
                 for (int c = 0; c < regionCount_.at({i, j}) - maxFeaturesRegion_; c++)
                 {
                     regionLandmarks_.at({i, j})[c]->RemoveLastObservation();
+                    regionLandmarks_.at({i, j})[c]->Terminate();
+                    numPruned++;
                 }
             }
         }
     }
+    numPruned_ += numPruned;
 }
 
 std::vector<data::Landmark>& TrackingModule::GetLandmarks()
@@ -7,6 +7,7 @@
 
 #include "feature/tracker.h"
 #include "feature/detector.h"
+#include "feature/detector_pool.h"
 #include "feature/region.h"
 #include "odometry/five_point.h"
 #include "data/frame.h"
@@ -28,10 +29,15 @@ public:
         std::vector<int> trackLengths;
         std::vector<std::vector<double>> failureRadDists;
         std::vector<std::vector<double>> successRadDists;
+        std::vector<int> keyframes;
+        std::vector<std::vector<double>> frameTrackTimes;
+        std::vector<std::vector<double>> kernelBenchmarks;
+        std::vector<std::vector<int>> frameRejectedCounts;
+        std::vector<std::vector<int>> frameLandmarkCounts;
     };
 
-    TrackingModule(std::unique_ptr<feature::Detector> &detector, std::unique_ptr<feature::Tracker> &tracker, std::unique_ptr<odometry::FivePoint> &checker, int minFeaturesRegion = 5, int maxFeaturesRegion = 5000);
-    TrackingModule(std::unique_ptr<feature::Detector> &&detector, std::unique_ptr<feature::Tracker> &&tracker, std::unique_ptr<odometry::FivePoint> &&checker, int minFeaturesRegion = 5, int maxFeaturesRegion = 5000);
+    TrackingModule(std::unique_ptr<feature::Detector> &detector, std::unique_ptr<feature::Tracker> &tracker, std::unique_ptr<odometry::FivePoint> &checker, int minFeaturesRegion = 5, int maxFeaturesRegion = 5000, double suppressionRadius = 0., bool adaptiveThresholds = false);
+    TrackingModule(std::unique_ptr<feature::Detector> &&detector, std::unique_ptr<feature::Tracker> &&tracker, std::unique_ptr<odometry::FivePoint> &&checker, int minFeaturesRegion = 5, int maxFeaturesRegion = 5000, double suppressionRadius = 0., bool adaptiveThresholds = false);
 
     void Update(std::unique_ptr<data::Frame> &frame);
     void Redetect();
@@ -63,6 +69,7 @@ private:
     void Prune();
 
     std::shared_ptr<feature::Detector> detector_;
+    std::shared_ptr<feature::DetectorPool> detectorPool_;
     std::shared_ptr<feature::Tracker> tracker_;
     std::shared_ptr<odometry::FivePoint> fivePointChecker_;
 
@@ -72,6 +79,13 @@ private:
 
     int minFeaturesRegion_;
     int maxFeaturesRegion_;
+    double suppressionRadius_;
+    bool adaptiveThresholds_;
+    double baseThreshold_;
+    bool integralThreshold_{false};
+    std::vector<double> regionThresholds_;
+    const double thresholdStep_{1.25};
+    const double thresholdRange_{16.};
     std::map<std::pair<int, int>, int> regionCount_;
     std::map<std::pair<int, int>, std::vector<data::Landmark*>> regionLandmarks_;
 
@@ -79,6 +93,7 @@ private:
     Visualization visualization_;
 
     int frameNum_{0};
+    int numPruned_{0};
 };
 
 }
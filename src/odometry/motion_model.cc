@@ -0,0 +1,54 @@
+#include "motion_model.h"
+
+#include "util/tf_util.h"
+
+namespace omni_slam
+{
+namespace odometry
+{
+
+void MotionModel::Update(const Matrix<double, 3, 4> &pose, double time)
+{
+    if (numPoses_ > 0)
+    {
+        velocity_ = util::TFUtil::CombineTransforms(util::TFUtil::InversePoseMatrix(lastPose_), pose);
+        velocityDuration_ = time - lastTime_;
+    }
+    lastPose_ = pose;
+    lastTime_ = time;
+    numPoses_++;
+}
+
+bool MotionModel::Predict(double time, Matrix<double, 3, 4> &pose) const
+{
+    if (numPoses_ < 2)
+    {
+        return false;
+    }
+    double scale = velocityDuration_ > 0 ? (time - lastTime_) / velocityDuration_ : 1.;
+    AngleAxisd rot(util::TFUtil::GetRotationFromPoseMatrix(velocity_));
+    rot.angle() *= scale;
+    Matrix<double, 3, 4> delta;
+    delta.block<3, 3>(0, 0) = rot.toRotationMatrix();
+    delta.block<3, 1>(0, 3) = scale * velocity_.block<3, 1>(0, 3);
+    pose = util::TFUtil::CombineTransforms(lastPose_, delta);
+    return true;
+}
+
+void MotionModel::Rebase(const Matrix<double, 3, 4> &pose)
+{
+    // Velocity is relative to the last pose, so a world frame correction only moves the anchor
+    if (numPoses_ > 0)
+    {
+        lastPose_ = pose;
+    }
+}
+
+void MotionModel::Reset()
+{
+    numPoses_ = 0;
+    velocityDuration_ = 0;
+}
+
+}
+}
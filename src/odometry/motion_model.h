@@ -0,0 +1,34 @@
+#ifndef _MOTION_MODEL_H_
+#define _MOTION_MODEL_H_
+
+#include <Eigen/Dense>
+
+using namespace Eigen;
+
+namespace omni_slam
+{
+namespace odometry
+{
+
+class MotionModel
+{
+public:
+    MotionModel() = default;
+
+    void Update(const Matrix<double, 3, 4> &pose, double time);
+    bool Predict(double time, Matrix<double, 3, 4> &pose) const;
+    void Rebase(const Matrix<double, 3, 4> &pose);
+    void Reset();
+
+private:
+    Matrix<double, 3, 4> lastPose_;
+    Matrix<double, 3, 4> velocity_;
+    double lastTime_{0};
+    double velocityDuration_{0};
+    int numPoses_{0};
+};
+
+}
+}
+
+#endif /* _MOTION_MODEL_H_ */
@@ -17,10 +17,11 @@ namespace omni_slam
 namespace odometry
 {
 
-PNP::PNP(int ransac_iterations, double reprojection_threshold, int num_refine_threads)
+PNP::PNP(int ransac_iterations, double reprojection_threshold, int num_refine_threads, double guided_inlier_ratio)
     : ransacIterations_(ransac_iterations),
     reprojThreshold_(reprojection_threshold),
-    numRefineThreads_(num_refine_threads)
+    numRefineThreads_(num_refine_threads),
+    guidedInlierRatio_(guided_inlier_ratio)
 {
 }
 
@@ -35,7 +36,7 @@ int PNP::Compute(const std::vector<data::Landmark> &landmarks, data::Frame &cur_
     int i = 0;
     for (const data::Landmark &landmark : landmarks)
     {
-        if (landmark.IsObservedInFrame(cur_frame.GetID()))
+        if (!landmark.IsTerminated() && landmark.IsObservedInFrame(cur_frame.GetID()))
         {
             if (cur_frame.HasStereoImage() && landmark.HasEstimatedPosition() && landmark.GetStereoObservationByFrameID(landmark.GetFirstFrameID()) != nullptr)
             {
@@ -70,7 +71,32 @@ int PNP::Compute(const std::vector<data::Landmark> &landmarks, data::Frame &cur_
         return 0;
     }
     Matrix<double, 3, 4> pose;
-    int inliers = RANSAC(xs, ys, yns, cur_frame.GetCameraModel(), pose);
+    int priorInliers = 0;
+    if (cur_frame.HasPredictedPose())
+    {
+        pose = cur_frame.GetPredictedInversePose();
+        priorInliers = GetInlierIndices(xs, yns, pose, cur_frame.GetCameraModel()).size();
+    }
+    Matrix<double, 3, 4> guidedPose = pose;
+    int guidedInliers = priorInliers;
+    if (guidedInlierRatio_ > 0 && !cur_frame.HasPredictedPose() && prev_frame.HasEstimatedPose())
+    {
+        // Without a prediction the guided path tries the reference frame's pose, which odometry passes as the last keyframe
+        guidedPose = prev_frame.GetEstimatedInversePose();
+        guidedInliers = GetInlierIndices(xs, yns, guidedPose, cur_frame.GetCameraModel()).size();
+    }
+    int inliers;
+    if (guidedInlierRatio_ > 0 && guidedInliers > 0 && guidedInliers >= guidedInlierRatio_ * xs.size())
+    {
+        pose = guidedPose;
+        inliers = guidedInliers;
+        numGuidedEstimates_++;
+    }
+    else
+    {
+        inliers = RANSAC(xs, ys, yns, cur_frame.GetCameraModel(), pose, priorInliers);
+        numRANSACEstimates_++;
+    }
     std::vector<int> indices = GetInlierIndices(xs, yns, pose, cur_frame.GetCameraModel());
     if (inliers > 3)
     {
@@ -89,9 +115,47 @@ int PNP::Compute(const std::vector<data::Landmark> &landmarks, data::Frame &cur_
     return inliers;
 }
 
-int PNP::RANSAC(const std::vector<Vector3d> &xs, const std::vector<Vector3d> &ys, const std::vector<Vector2d> &yns, const camera::CameraModel<> &camera_model, Matrix<double, 3, 4> &pose) const
+int PNP::Compute(const std::vector<Vector3d> &xs, const std::vector<Vector2d> &pixels, const camera::CameraModel<> &camera_model, Matrix<double, 3, 4> &pose, std::vector<int> &inlier_indices) const
+{
+    std::vector<Vector3d> validXs;
+    std::vector<Vector2d> yns;
+    std::vector<Vector3d> ys;
+    std::vector<int> indexToInput;
+    for (int i = 0; i < xs.size(); i++)
+    {
+        Vector3d bearing;
+        if (!camera_model.UnprojectToBearing(pixels[i], bearing))
+        {
+            continue;
+        }
+        validXs.push_back(xs[i]);
+        yns.push_back(pixels[i]);
+        ys.push_back(bearing);
+        indexToInput.push_back(i);
+    }
+    inlier_indices.clear();
+    if (validXs.size() < 4)
+    {
+        return 0;
+    }
+    int inliers = RANSAC(validXs, ys, yns, camera_model, pose);
+    numRANSACEstimates_++;
+    if (inliers == 0)
+    {
+        return 0;
+    }
+    std::vector<int> indices = GetInlierIndices(validXs, yns, pose, camera_model);
+    inlier_indices.reserve(indices.size());
+    for (int inx : indices)
+    {
+        inlier_indices.push_back(indexToInput[inx]);
+    }
+    return indices.size();
+}
+
+int PNP::RANSAC(const std::vector<Vector3d> &xs, const std::vector<Vector3d> &ys, const std::vector<Vector2d> &yns, const camera::CameraModel<> &camera_model, Matrix<double, 3, 4> &pose, int min_inliers) const
 {
-    int maxInliers = 0;
+    int maxInliers = min_inliers;
     #pragma omp parallel for
     for (int i = 0; i < ransacIterations_; i++)
     {
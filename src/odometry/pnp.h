@@ -18,11 +18,12 @@ namespace odometry
 class PNP : public PoseEstimator
 {
 public:
-    PNP(int ransac_iterations, double reprojection_threshold, int num_refine_threads = 1);
+    PNP(int ransac_iterations, double reprojection_threshold, int num_refine_threads = 1, double guided_inlier_ratio = 0.);
     int Compute(const std::vector<data::Landmark> &landmarks, data::Frame &cur_frame, const data::Frame &prev_frame, std::vector<int> &inlier_indices) const;
+    int Compute(const std::vector<Vector3d> &xs, const std::vector<Vector2d> &pixels, const camera::CameraModel<> &camera_model, Matrix<double, 3, 4> &pose, std::vector<int> &inlier_indices) const;
 
 private:
-    int RANSAC(const std::vector<Vector3d> &xs, const std::vector<Vector3d> &ys, const std::vector<Vector2d> &yns, const camera::CameraModel<> &camera_model, Matrix<double, 3, 4> &pose) const;
+    int RANSAC(const std::vector<Vector3d> &xs, const std::vector<Vector3d> &ys, const std::vector<Vector2d> &yns, const camera::CameraModel<> &camera_model, Matrix<double, 3, 4> &pose, int min_inliers = 0) const;
     bool Refine(const std::vector<Vector3d> &xs, const std::vector<const data::Feature*> &features, const std::vector<int> indices, Matrix<double, 3, 4> &pose) const;
     double P4P(const std::vector<Vector3d> &xs, const std::vector<Vector3d> &ys, const std::vector<Vector2d> &yns, std::vector<int> indices, const camera::CameraModel<> &camera_model, Matrix<double, 3, 4> &pose) const;
     std::vector<int> GetInlierIndices(const std::vector<Vector3d> &xs, const std::vector<Vector2d> &yns, const Matrix<double, 3, 4> &pose, const camera::CameraModel<> &camera_model) const;
@@ -30,6 +31,7 @@ private:
     int ransacIterations_;
     double reprojThreshold_;
     int numRefineThreads_;
+    double guidedInlierRatio_;
 };
 
 }
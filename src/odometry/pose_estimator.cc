@@ -11,5 +11,15 @@ int PoseEstimator::Compute(const std::vector<data::Landmark> &landmarks, data::F
     return Compute(landmarks, cur_frame, prev_frame, temp);
 }
 
+int PoseEstimator::GetNumGuidedEstimates() const
+{
+    return numGuidedEstimates_;
+}
+
+int PoseEstimator::GetNumRANSACEstimates() const
+{
+    return numRANSACEstimates_;
+}
+
 }
 }
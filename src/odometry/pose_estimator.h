@@ -14,6 +14,13 @@ class PoseEstimator
 public:
     virtual int Compute(const std::vector<data::Landmark> &landmarks, data::Frame &cur_frame, const data::Frame &prev_frame, std::vector<int> &inlier_indices) const = 0;
     int Compute(const std::vector<data::Landmark> &landmarks, data::Frame &cur_frame, const data::Frame &prev_frame) const;
+
+    int GetNumGuidedEstimates() const;
+    int GetNumRANSACEstimates() const;
+
+protected:
+    mutable int numGuidedEstimates_{0};
+    mutable int numRANSACEstimates_{0};
 };
 
 }
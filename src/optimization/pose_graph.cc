@@ -0,0 +1,117 @@
+#include "pose_graph.h"
+
+#include "relative_pose_error.h"
+
+#include "util/tf_util.h"
+
+#include <iostream>
+
+namespace omni_slam
+{
+namespace optimization
+{
+
+PoseGraph::PoseGraph(int max_iterations, double loss_coeff, int num_threads, bool log)
+    : lossCoeff_(loss_coeff)
+{
+    solverOptions_.max_num_iterations = max_iterations;
+    solverOptions_.linear_solver_type = ceres::SPARSE_NORMAL_CHOLESKY;
+    solverOptions_.num_threads = num_threads;
+    solverOptions_.minimizer_progress_to_stdout = log;
+    solverOptions_.logging_type = log ? ceres::PER_MINIMIZER_ITERATION : ceres::SILENT;
+}
+
+void PoseGraph::AddNode(const int id, const Matrix<double, 3, 4> &inverse_pose)
+{
+    Quaterniond quat(inverse_pose.block<3, 3>(0, 0));
+    quat.normalize();
+    const Vector3d &t = inverse_pose.block<3, 1>(0, 3);
+    nodes_[id] = {std::vector<double>(quat.coeffs().data(), quat.coeffs().data() + 4), std::vector<double>(t.data(), t.data() + 3)};
+}
+
+void PoseGraph::AddEdge(const int id1, const int id2, const Matrix<double, 3, 4> &rel_pose, const bool loop, const double weight)
+{
+    edges_.push_back({id1, id2, rel_pose, loop, weight});
+}
+
+bool PoseGraph::Optimize(const int fixed_id)
+{
+    if (nodes_.find(fixed_id) == nodes_.end())
+    {
+        return false;
+    }
+    ceres::Problem problem;
+    ceres::LossFunction *loss_function = new ceres::HuberLoss(lossCoeff_);
+    bool hasLoop = false;
+    for (auto &node : nodes_)
+    {
+        problem.AddParameterBlock(&node.second.first[0], 4, new ceres::EigenQuaternionParameterization());
+        problem.AddParameterBlock(&node.second.second[0], 3);
+    }
+    for (const Edge &edge : edges_)
+    {
+        auto it1 = nodes_.find(edge.id1);
+        auto it2 = nodes_.find(edge.id2);
+        if (it1 == nodes_.end() || it2 == nodes_.end())
+        {
+            continue;
+        }
+        // Odometry edges are trusted as-is, only loop edges are robustified
+        problem.AddResidualBlock(RelativePoseError::Create(edge.relPose, edge.weight), edge.loop ? loss_function : nullptr, &it1->second.first[0], &it1->second.second[0], &it2->second.first[0], &it2->second.second[0]);
+        hasLoop = hasLoop || edge.loop;
+    }
+    if (!hasLoop)
+    {
+        delete loss_function;
+    }
+    problem.SetParameterBlockConstant(&nodes_[fixed_id].first[0]);
+    problem.SetParameterBlockConstant(&nodes_[fixed_id].second[0]);
+
+    ceres::Solver::Summary summary;
+    ceres::Solve(solverOptions_, &problem, &summary);
+    if (solverOptions_.minimizer_progress_to_stdout)
+    {
+        std::cout << summary.FullReport() << std::endl;
+    }
+    return summary.IsSolutionUsable();
+}
+
+bool PoseGraph::HasNode(const int id) const
+{
+    return nodes_.find(id) != nodes_.end();
+}
+
+bool PoseGraph::GetInversePose(const int id, Matrix<double, 3, 4> &inverse_pose) const
+{
+    auto it = nodes_.find(id);
+    if (it == nodes_.end())
+    {
+        return false;
+    }
+    const Quaterniond quat = Map<const Quaterniond>(&it->second.first[0]);
+    const Vector3d t = Map<const Vector3d>(&it->second.second[0]);
+    inverse_pose = util::TFUtil::QuaternionTranslationToPoseMatrix(quat, t);
+    return true;
+}
+
+void PoseGraph::GetInversePoses(std::map<int, Matrix<double, 3, 4>> &inverse_poses) const
+{
+    inverse_poses.clear();
+    for (auto &node : nodes_)
+    {
+        GetInversePose(node.first, inverse_poses[node.first]);
+    }
+}
+
+int PoseGraph::GetNumNodes() const
+{
+    return nodes_.size();
+}
+
+int PoseGraph::GetNumEdges() const
+{
+    return edges_.size();
+}
+
+}
+}
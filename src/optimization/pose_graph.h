@@ -0,0 +1,51 @@
+#ifndef _POSE_GRAPH_H_
+#define _POSE_GRAPH_H_
+
+#include <ceres/ceres.h>
+#include <Eigen/Dense>
+#include <vector>
+#include <map>
+
+using namespace Eigen;
+
+namespace omni_slam
+{
+namespace optimization
+{
+
+class PoseGraph
+{
+public:
+    PoseGraph(int max_iterations = 100, double loss_coeff = 0.1, int num_threads = 1, bool log = false);
+
+    void AddNode(const int id, const Matrix<double, 3, 4> &inverse_pose);
+    void AddEdge(const int id1, const int id2, const Matrix<double, 3, 4> &rel_pose, const bool loop = false, const double weight = 1.);
+    bool Optimize(const int fixed_id);
+
+    bool HasNode(const int id) const;
+    bool GetInversePose(const int id, Matrix<double, 3, 4> &inverse_pose) const;
+    void GetInversePoses(std::map<int, Matrix<double, 3, 4>> &inverse_poses) const;
+    int GetNumNodes() const;
+    int GetNumEdges() const;
+
+private:
+    struct Edge
+    {
+        int id1;
+        int id2;
+        Matrix<double, 3, 4> relPose;
+        bool loop;
+        double weight;
+    };
+
+    std::map<int, std::pair<std::vector<double>, std::vector<double>>> nodes_;
+    std::vector<Edge> edges_;
+    ceres::Solver::Options solverOptions_;
+
+    double lossCoeff_;
+};
+
+}
+}
+
+#endif /* _POSE_GRAPH_H_ */
@@ -0,0 +1,56 @@
+#ifndef _RELATIVE_POSE_ERROR_H_
+#define _RELATIVE_POSE_ERROR_H_
+
+#include <ceres/ceres.h>
+#include <Eigen/Dense>
+
+using namespace Eigen;
+
+namespace omni_slam
+{
+namespace optimization
+{
+
+class RelativePoseError
+{
+public:
+    RelativePoseError(const Matrix<double, 3, 4> &rel_pose, const double weight)
+        : relOrientation_(Quaterniond(rel_pose.block<3, 3>(0, 0)).normalized()),
+        relTranslation_(rel_pose.block<3, 1>(0, 3)),
+        weight_(weight)
+    {
+    }
+
+    template<typename T>
+    bool operator()(const T* const orientation1, const T* const translation1, const T* const orientation2, const T* const translation2, T *residuals) const
+    {
+        const Quaternion<T> q1 = Map<const Quaternion<T>>(orientation1);
+        const Matrix<T, 3, 1> t1 = Map<const Matrix<T, 3, 1>>(translation1);
+        const Quaternion<T> q2 = Map<const Quaternion<T>>(orientation2);
+        const Matrix<T, 3, 1> t2 = Map<const Matrix<T, 3, 1>>(translation2);
+        const Quaternion<T> qRel = q2 * q1.conjugate();
+        const Matrix<T, 3, 1> tRel = t2 - qRel * t1;
+        const Quaternion<T> qMeas = relOrientation_.cast<T>();
+        const Quaternion<T> qErr = qMeas.conjugate() * qRel;
+        const Matrix<T, 3, 1> tErr = qMeas.conjugate() * (tRel - relTranslation_.cast<T>());
+        Map<Matrix<T, 6, 1>> res(residuals);
+        res.template block<3, 1>(0, 0) = T(weight_) * tErr;
+        res.template block<3, 1>(3, 0) = T(2. * weight_) * qErr.vec();
+        return true;
+    }
+
+    static ceres::CostFunction* Create(const Matrix<double, 3, 4> &rel_pose, const double weight)
+    {
+        return new ceres::AutoDiffCostFunction<RelativePoseError, 6, 4, 3, 4, 3>(new RelativePoseError(rel_pose, weight));
+    }
+
+private:
+    const Quaterniond relOrientation_;
+    const Vector3d relTranslation_;
+    const double weight_;
+};
+
+}
+}
+
+#endif /* _RELATIVE_POSE_ERROR_H_ */
@@ -24,6 +24,11 @@ int Triangulator::Triangulate(std::vector<data::Landmark> &landmarks) const
         {
             continue;
         }
+        // Terminated landmarks gain no new views, so an existing estimate is left to bundle adjustment
+        if (landmark.HasEstimatedPosition() && landmark.IsTerminated())
+        {
+            continue;
+        }
         Vector3d point;
         if (TriangulateNViews(landmark.GetObservations(), point))
         {
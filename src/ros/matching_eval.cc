@@ -2,6 +2,8 @@
 
 #include "feature/matcher.h"
 #include "feature/detector.h"
+#include "feature/vocabulary_tree.h"
+#include "feature/bow_database.h"
 #include "odometry/five_point.h"
 
 using namespace std;
@@ -17,9 +19,19 @@ MatchingEval::MatchingEval(const ::ros::NodeHandle &nh, const ::ros::NodeHandle
     map<string, double> detectorParams;
     map<string, double> descriptorParams;
     double matcherMaxDist;
+    bool matcherApproximate;
+    bool matcherBenchmarkExact;
+    bool matcherBenchmarkHamming;
+    bool matcherRatioTest;
+    double matcherMaxRatio;
+    int bowCandidates;
+    int bowBranching;
+    int bowDepth;
+    int bowTrainingFrames;
     double overlapThresh;
     double distThresh;
     bool localUnwarp;
+    int localUnwarpCacheMB;
     double fivePointThreshold;
     int fivePointRansacIterations;
 
@@ -28,9 +40,19 @@ MatchingEval::MatchingEval(const ::ros::NodeHandle &nh, const ::ros::NodeHandle
     nhp_.param("descriptor_type", descriptorType_, string("SIFT"));
     nhp_.getParam("descriptor_parameters", descriptorParams);
     nhp_.param("matcher_max_dist", matcherMaxDist, 0.);
+    nhp_.param("matcher_approximate", matcherApproximate, false);
+    nhp_.param("matcher_benchmark_exact", matcherBenchmarkExact, false);
+    nhp_.param("matcher_benchmark_hamming", matcherBenchmarkHamming, false);
+    nhp_.param("matcher_ratio_test", matcherRatioTest, false);
+    nhp_.param("matcher_max_ratio", matcherMaxRatio, 0.);
+    nhp_.param("bow_candidates", bowCandidates, 0);
+    nhp_.param("bow_branching", bowBranching, 10);
+    nhp_.param("bow_depth", bowDepth, 4);
+    nhp_.param("bow_training_frames", bowTrainingFrames, 10);
     nhp_.param("feature_overlap_threshold", overlapThresh, 0.5);
     nhp_.param("feature_distance_threshold", distThresh, 10.);
     nhp_.param("local_unwarp", localUnwarp, false);
+    nhp_.param("local_unwarp_cache_mb", localUnwarpCacheMB, 64);
     nhp_.param("estimator_epipolar_threshold", fivePointThreshold, 0.01745240643);
     nhp_.param("estimator_iterations", fivePointRansacIterations, 1000);
 
@@ -41,17 +63,22 @@ MatchingEval::MatchingEval(const ::ros::NodeHandle &nh, const ::ros::NodeHandle
         {
             ROS_WARN("Invalid feature detector descriptor combination specified");
         }
-        detector.reset(new feature::Detector(detectorType_, descriptorType_, detectorParams, descriptorParams, localUnwarp));
+        detector.reset(new feature::Detector(detectorType_, descriptorType_, detectorParams, descriptorParams, localUnwarp, localUnwarpCacheMB));
     }
     else
     {
         ROS_ERROR("Invalid feature detector specified");
     }
 
-    unique_ptr<feature::Matcher> matcher(new feature::Matcher(descriptorType_, matcherMaxDist));
+    unique_ptr<feature::Matcher> matcher(new feature::Matcher(descriptorType_, matcherMaxDist, matcherApproximate, matcherRatioTest, matcherMaxRatio));
     unique_ptr<odometry::FivePoint> estimator(new odometry::FivePoint(fivePointRansacIterations, fivePointThreshold, 0, false, 0));
 
-    matchingModule_.reset(new module::MatchingModule(detector, matcher, estimator, overlapThresh, distThresh));
+    matchingModule_.reset(new module::MatchingModule(detector, matcher, estimator, overlapThresh, distThresh, matcherBenchmarkExact, matcherBenchmarkHamming));
+    if (bowCandidates > 0)
+    {
+        unique_ptr<feature::BowDatabase> bowDatabase(new feature::BowDatabase(unique_ptr<feature::VocabularyTree>(new feature::VocabularyTree(bowBranching, bowDepth))));
+        matchingModule_->SetPlaceRecognition(bowDatabase, bowCandidates, bowTrainingFrames);
+    }
 }
 
 void MatchingEval::InitPublishers()
@@ -78,6 +105,21 @@ void MatchingEval::GetResultsData(std::map<std::string, std::vector<std::vector<
     data["roc_curves"] = stats.rocCurves;
     data["precision_recall_curves"] = stats.precRecCurves;
     data["rotation_errors"] = stats.rotationErrors;
+    data["match_times"] = stats.frameMatchTimes;
+    if (!stats.approximateMatchBenchmarks.empty())
+    {
+        data["approximate_match_benchmarks"] = stats.approximateMatchBenchmarks;
+    }
+    if (!stats.hammingMatchBenchmarks.empty())
+    {
+        data["hamming_match_benchmarks"] = stats.hammingMatchBenchmarks;
+    }
+    if (!stats.bowCandidates.empty())
+    {
+        data["bow_candidates"] = stats.bowCandidates;
+        data["bow_query_times"] = stats.bowQueryTimes;
+        data["bow_retrievals"] = stats.bowRetrievals;
+    }
 }
 
 bool MatchingEval::GetAttributes(std::map<std::string, std::string> &attributes)
@@ -21,6 +21,7 @@ OdometryEval<Stereo>::OdometryEval(const ::ros::NodeHandle &nh, const ::ros::Nod
 {
     double reprojThresh;
     int iterations;
+    double guidedInlierRatio;
     int baMaxIter;
     double baLossCoeff;
     bool logCeres;
@@ -30,10 +31,12 @@ OdometryEval<Stereo>::OdometryEval(const ::ros::NodeHandle &nh, const ::ros::Nod
     int fivePointRansacIterations;
 
     string odometryType;
+    bool useMotionModel;
 
     this->nhp_.param("output_frame", cameraFrame_, std::string("map"));
     this->nhp_.param("pnp_inlier_threshold", reprojThresh, 10.);
     this->nhp_.param("pnp_iterations", iterations, 1000);
+    this->nhp_.param("pnp_guided_inlier_ratio", guidedInlierRatio, 0.);
     this->nhp_.param("bundle_adjustment_max_iterations", baMaxIter, 500);
     this->nhp_.param("bundle_adjustment_loss_coefficient", baLossCoeff, 0.1);
     this->nhp_.param("bundle_adjustment_logging", logCeres, false);
@@ -43,11 +46,12 @@ OdometryEval<Stereo>::OdometryEval(const ::ros::NodeHandle &nh, const ::ros::Nod
     this->nhp_.param("tracker_checker_iterations", fivePointRansacIterations, 1000);
 
     this->nhp_.param("odometry_type", odometryType, string("pnp"));
+    this->nhp_.param("odometry_motion_model", useMotionModel, false);
 
     unique_ptr<odometry::PoseEstimator> poseEstimator;
     if (odometryType == "pnp")
     {
-        poseEstimator.reset(new odometry::PNP(iterations, reprojThresh, numCeresThreads));
+        poseEstimator.reset(new odometry::PNP(iterations, reprojThresh, numCeresThreads, guidedInlierRatio));
     }
     else if (odometryType == "five_point")
     {
@@ -64,7 +68,7 @@ OdometryEval<Stereo>::OdometryEval(const ::ros::NodeHandle &nh, const ::ros::Nod
 
     unique_ptr<optimization::BundleAdjuster> bundleAdjuster(new optimization::BundleAdjuster(baMaxIter, baLossCoeff, numCeresThreads, logCeres));
 
-    odometryModule_.reset(new module::OdometryModule(poseEstimator, bundleAdjuster));
+    odometryModule_.reset(new module::OdometryModule(poseEstimator, bundleAdjuster, useMotionModel));
 }
 
 template <bool Stereo>
@@ -94,6 +98,7 @@ void OdometryEval<Stereo>::InitPublishers()
 template <bool Stereo>
 void OdometryEval<Stereo>::ProcessFrame(unique_ptr<data::Frame> &&frame)
 {
+    odometryModule_->PredictPose(*frame);
     this->trackingModule_->Update(frame);
     odometryModule_->Update(this->trackingModule_->GetLandmarks(), this->trackingModule_->GetFrames().back(), this->trackingModule_->GetLastKeyframe());
     this->trackingModule_->Redetect();
@@ -127,6 +132,7 @@ void OdometryEval<Stereo>::GetResultsData(std::map<std::string, std::vector<std:
     module::OdometryModule::Stats &stats = odometryModule_->GetStats();
     data["inlier_radial_distances"] = stats.inlierRadDists;
     data["outlier_radial_distances"] = stats.outlierRadDists;
+    data["estimation_paths"] = stats.estimationPaths;
     data["estimated_poses"] = odometryData_;
     bool first = true;
     for (const std::unique_ptr<data::Frame> &frame : this->trackingModule_->GetFrames())
@@ -3,6 +3,9 @@
 #include "odometry/pnp.h"
 #include "optimization/bundle_adjuster.h"
 #include "module/tracking_module.h"
+#include "feature/vocabulary_tree.h"
+#include "feature/bow_database.h"
+#include "optimization/pose_graph.h"
 
 #include "geometry_msgs/PoseStamped.h"
 #include "nav_msgs/Path.h"
@@ -17,8 +20,51 @@ namespace ros
 SLAMEval::SLAMEval(const ::ros::NodeHandle &nh, const ::ros::NodeHandle &nh_private)
     : OdometryEval<true>(nh, nh_private), ReconstructionEval<true>(nh, nh_private), StereoEval(nh, nh_private)
 {
+    bool loopClosure;
+    string loopDescriptorType;
+    int loopCandidates;
+    int loopMinFrameGap;
+    int loopMinInliers;
+    int loopTrainingFrames;
+    int loopBranching;
+    int loopDepth;
+    double reprojThresh;
+    int iterations;
+    int poseGraphMaxIter;
+    double poseGraphLossCoeff;
+    bool logCeres;
+    int numCeresThreads;
+
     this->nhp_.param("local_bundle_adjustment_window", baSlidingWindow_, 0);
     this->nhp_.param("local_bundle_adjustment_interval", baSlidingInterval_, 0);
+    this->nhp_.param("loop_closure", loopClosure, false);
+    this->nhp_.param("loop_closure_descriptor_type", loopDescriptorType, string("ORB"));
+    this->nhp_.param("loop_closure_candidates", loopCandidates, 3);
+    this->nhp_.param("loop_closure_min_frame_gap", loopMinFrameGap, 50);
+    this->nhp_.param("loop_closure_min_inliers", loopMinInliers, 30);
+    this->nhp_.param("loop_closure_training_frames", loopTrainingFrames, 10);
+    this->nhp_.param("loop_closure_vocabulary_branching", loopBranching, 10);
+    this->nhp_.param("loop_closure_vocabulary_depth", loopDepth, 4);
+    this->nhp_.param("pnp_inlier_threshold", reprojThresh, 10.);
+    this->nhp_.param("pnp_iterations", iterations, 1000);
+    this->nhp_.param("pose_graph_max_iterations", poseGraphMaxIter, 100);
+    this->nhp_.param("pose_graph_loss_coefficient", poseGraphLossCoeff, 0.1);
+    this->nhp_.param("bundle_adjustment_logging", logCeres, false);
+    this->nhp_.param("bundle_adjustment_num_threads", numCeresThreads, 1);
+
+    if (loopClosure)
+    {
+        if (!feature::Detector::IsDescriptorTypeValid(loopDescriptorType))
+        {
+            ROS_ERROR("Invalid loop closure descriptor type specified");
+            return;
+        }
+        unique_ptr<feature::Detector> detector(new feature::Detector(loopDescriptorType, loopDescriptorType, map<string, double>(), map<string, double>()));
+        unique_ptr<feature::BowDatabase> database(new feature::BowDatabase(unique_ptr<feature::VocabularyTree>(new feature::VocabularyTree(loopBranching, loopDepth))));
+        unique_ptr<odometry::PNP> pnp(new odometry::PNP(iterations, reprojThresh));
+        unique_ptr<optimization::PoseGraph> poseGraph(new optimization::PoseGraph(poseGraphMaxIter, poseGraphLossCoeff, numCeresThreads, logCeres));
+        loopClosureModule_.reset(new module::LoopClosureModule(detector, database, pnp, poseGraph, loopCandidates, loopMinFrameGap, loopMinInliers, loopTrainingFrames));
+    }
 }
 
 void SLAMEval::InitPublishers()
@@ -30,6 +76,11 @@ void SLAMEval::InitPublishers()
 
 void SLAMEval::ProcessFrame(unique_ptr<data::Frame> &&frame)
 {
+    if (loopClosureModule_ && loopClosureModule_->ApplyCorrection(trackingModule_->GetFrames(), trackingModule_->GetLandmarks()))
+    {
+        odometryModule_->ApplyCorrection(*trackingModule_->GetFrames().back());
+    }
+    odometryModule_->PredictPose(*frame);
     trackingModule_->Update(frame);
     odometryModule_->Update(trackingModule_->GetLandmarks(), trackingModule_->GetFrames().back(), trackingModule_->GetLastKeyframe());
     reconstructionModule_->Update(trackingModule_->GetLandmarks());
@@ -49,11 +100,24 @@ void SLAMEval::ProcessFrame(unique_ptr<data::Frame> &&frame)
     }
     trackingModule_->Redetect();
     stereoModule_->Update(*trackingModule_->GetFrames().back(), trackingModule_->GetLandmarks());
+    if (loopClosureModule_)
+    {
+        const std::vector<int> &keyframes = trackingModule_->GetStats().keyframes;
+        if (!keyframes.empty() && keyframes.back() == frameNum_)
+        {
+            loopClosureModule_->Update(trackingModule_->GetLandmarks(), *trackingModule_->GetFrames().back());
+        }
+    }
     frameNum_++;
 }
 
 void SLAMEval::Finish()
 {
+    if (loopClosureModule_)
+    {
+        loopClosureModule_->Finish();
+        loopClosureModule_->ApplyCorrection(trackingModule_->GetFrames(), trackingModule_->GetLandmarks());
+    }
     bool first = true;
     for (const std::unique_ptr<data::Frame> &frame : this->trackingModule_->GetFrames())
     {
@@ -75,6 +139,12 @@ void SLAMEval::GetResultsData(std::map<std::string, std::vector<std::vector<doub
     OdometryEval<true>::GetResultsData(data);
     data["estimated_poses"] = odometryData_;
     ReconstructionEval<true>::GetResultsData(data);
+    if (loopClosureModule_)
+    {
+        module::LoopClosureModule::Stats &stats = loopClosureModule_->GetStats();
+        data["loop_closures"] = stats.loopClosures;
+        data["pose_graph_optimizations"] = stats.optimizations;
+    }
 }
 
 void SLAMEval::Visualize(cv_bridge::CvImagePtr &base_img)
@@ -4,6 +4,7 @@
 #include "odometry_eval.h"
 #include "reconstruction_eval.h"
 #include "stereo_eval.h"
+#include "module/loop_closure_module.h"
 #include <ros/ros.h>
 #include <vector>
 
@@ -31,6 +32,8 @@ private:
     int baSlidingInterval_;
     int frameNum_{0};
 
+    std::unique_ptr<module::LoopClosureModule> loopClosureModule_;
+
     std::vector<std::vector<double>> odometryData_;
 };
 
@@ -1,6 +1,7 @@
 #include "stereo_eval.h"
 
 #include "stereo/lk_stereo_matcher.h"
+#include "stereo/rectified_stereo_matcher.h"
 #include "module/tracking_module.h"
 
 using namespace std;
@@ -13,17 +14,37 @@ namespace ros
 StereoEval::StereoEval(const ::ros::NodeHandle &nh, const ::ros::NodeHandle &nh_private)
     : TrackingEval<true>(nh, nh_private)
 {
+    string matcherType;
     int windowSize;
     int numScales;
     double errThresh;
     double epiThresh;
+    int patchSize;
+    int maxDisparity;
+    double patchErrThresh;
 
+    this->nhp_.param("stereo_matcher_type", matcherType, string("lk"));
     this->nhp_.param("stereo_matcher_window_size", windowSize, 256);
     this->nhp_.param("stereo_matcher_num_scales", numScales, 5);
     this->nhp_.param("stereo_matcher_error_threshold", errThresh, 20.);
     this->nhp_.param("stereo_matcher_epipolar_threshold", epiThresh, 0.005);
+    this->nhp_.param("stereo_matcher_patch_size", patchSize, 11);
+    this->nhp_.param("stereo_matcher_max_disparity", maxDisparity, 64);
+    this->nhp_.param("stereo_matcher_patch_error_threshold", patchErrThresh, 20.);
 
-    unique_ptr<stereo::StereoMatcher> stereo(new stereo::LKStereoMatcher(epiThresh, windowSize, numScales, errThresh));
+    unique_ptr<stereo::StereoMatcher> stereo;
+    if (matcherType == "rectified")
+    {
+        stereo.reset(new stereo::RectifiedStereoMatcher(epiThresh, patchSize, maxDisparity, patchErrThresh));
+    }
+    else
+    {
+        if (matcherType != "lk")
+        {
+            ROS_ERROR("Invalid stereo matcher type specified, falling back to lk");
+        }
+        stereo.reset(new stereo::LKStereoMatcher(epiThresh, windowSize, numScales, errThresh));
+    }
 
     stereoModule_.reset(new module::StereoModule(stereo));
 }
@@ -47,6 +68,7 @@ void StereoEval::GetResultsData(std::map<std::string, std::vector<std::vector<do
 {
     module::StereoModule::Stats &stats = stereoModule_->GetStats();
     data["depth_errors"] = stats.depthErrRadDists;
+    data["stereo_match_times"] = stats.frameMatchTimes;
 }
 
 void StereoEval::Visualize(cv_bridge::CvImagePtr &base_img, cv_bridge::CvImagePtr &base_stereo_img)
@@ -3,6 +3,10 @@
 #include "feature/lk_tracker.h"
 #include "feature/descriptor_tracker.h"
 #include "feature/detector.h"
+#include "feature/parallax_keyframe_policy.h"
+#include "feature/survival_keyframe_policy.h"
+#include "feature/flow_keyframe_policy.h"
+#include "feature/time_keyframe_policy.h"
 #include "odometry/five_point.h"
 
 using namespace std;
@@ -25,11 +29,26 @@ TrackingEval<Stereo>::TrackingEval(const ::ros::NodeHandle &nh, const ::ros::Nod
     int fivePointRansacIterations;
     double trackerDeltaPixelErrorThresh;
     double trackerErrorThresh;
+    int trackerTermCount;
+    double trackerTermEps;
+    int trackerChunkSize;
     map<string, double> detectorParams;
     map<string, double> descriptorParams;
     int minFeaturesRegion;
     int maxFeaturesRegion;
+    double redetectSuppressionRadius;
+    bool redetectAdaptiveThresholds;
     string trackerType;
+    string keyframePolicy;
+    double keyframeParallaxThresh;
+    double keyframeSurvivalThresh;
+    double keyframeFlowThresh;
+    double keyframeTimeThresh;
+    bool trackerNativeLK;
+    double trackerFBThresh;
+    bool trackerSphericalRemap;
+    bool trackerBenchmarkLK;
+    double trackerSearchRadius;
 
     this->nhp_.param("detector_type", detectorType, string("GFTT"));
     this->nhp_.param("descriptor_type", descriptorType, string("ORB"));
@@ -39,12 +58,27 @@ TrackingEval<Stereo>::TrackingEval(const ::ros::NodeHandle &nh, const ::ros::Nod
     this->nhp_.param("tracker_checker_iterations", fivePointRansacIterations, 1000);
     this->nhp_.param("tracker_delta_pixel_error_threshold", trackerDeltaPixelErrorThresh, 5.0);
     this->nhp_.param("tracker_error_threshold", trackerErrorThresh, 20.);
+    this->nhp_.param("tracker_term_count", trackerTermCount, 50);
+    this->nhp_.param("tracker_term_epsilon", trackerTermEps, 0.01);
+    this->nhp_.param("tracker_chunk_size", trackerChunkSize, 256);
     this->nhp_.param("min_features_per_region", minFeaturesRegion, 5);
     this->nhp_.param("max_features_per_region", maxFeaturesRegion, 5000);
+    this->nhp_.param("redetect_suppression_radius", redetectSuppressionRadius, 0.);
+    this->nhp_.param("redetect_adaptive_thresholds", redetectAdaptiveThresholds, false);
     this->nhp_.getParam("detector_parameters", detectorParams);
     this->nhp_.getParam("descriptor_parameters", descriptorParams);
     this->nhp_.param("keyframe_interval", keyframeInterval, 1);
     this->nhp_.param("tracker_type", trackerType, string("lk"));
+    this->nhp_.param("keyframe_policy", keyframePolicy, string("interval"));
+    this->nhp_.param("keyframe_parallax_threshold", keyframeParallaxThresh, 5.);
+    this->nhp_.param("keyframe_survival_threshold", keyframeSurvivalThresh, 0.7);
+    this->nhp_.param("keyframe_flow_threshold", keyframeFlowThresh, 20.);
+    this->nhp_.param("keyframe_time_threshold", keyframeTimeThresh, 0.5);
+    this->nhp_.param("tracker_native_lk", trackerNativeLK, false);
+    this->nhp_.param("tracker_fb_threshold", trackerFBThresh, 0.);
+    this->nhp_.param("tracker_spherical_remap", trackerSphericalRemap, false);
+    this->nhp_.param("tracker_benchmark_lk", trackerBenchmarkLK, false);
+    this->nhp_.param("tracker_search_radius", trackerSearchRadius, 0.);
 
     unique_ptr<feature::Detector> detector;
     if (feature::Detector::IsDetectorTypeValid(detectorType))
@@ -66,20 +100,44 @@ TrackingEval<Stereo>::TrackingEval(const ::ros::NodeHandle &nh, const ::ros::Nod
     unique_ptr<feature::Tracker> tracker;
     if (trackerType == "lk")
     {
-        tracker.reset(new feature::LKTracker(trackerWindowSize, trackerNumScales, trackerDeltaPixelErrorThresh, trackerErrorThresh, keyframeInterval));
+        tracker.reset(new feature::LKTracker(trackerWindowSize, trackerNumScales, trackerDeltaPixelErrorThresh, trackerErrorThresh, keyframeInterval, trackerTermCount, trackerTermEps, trackerChunkSize, trackerNativeLK, trackerFBThresh, trackerSphericalRemap, trackerBenchmarkLK));
     }
     else if (trackerType == "descriptor")
     {
-        tracker.reset(new feature::DescriptorTracker(detectorType, descriptorType, detectorParams, descriptorParams, trackerErrorThresh, keyframeInterval));
+        tracker.reset(new feature::DescriptorTracker(detectorType, descriptorType, detectorParams, descriptorParams, trackerErrorThresh, keyframeInterval, trackerSearchRadius));
     }
     else
     {
         ROS_ERROR("Invalid tracker type specified");
     }
 
+    if (tracker)
+    {
+        if (keyframePolicy == "parallax")
+        {
+            tracker->SetKeyframePolicy(unique_ptr<feature::KeyframePolicy>(new feature::ParallaxKeyframePolicy(keyframeParallaxThresh)));
+        }
+        else if (keyframePolicy == "survival")
+        {
+            tracker->SetKeyframePolicy(unique_ptr<feature::KeyframePolicy>(new feature::SurvivalKeyframePolicy(keyframeSurvivalThresh)));
+        }
+        else if (keyframePolicy == "flow")
+        {
+            tracker->SetKeyframePolicy(unique_ptr<feature::KeyframePolicy>(new feature::FlowKeyframePolicy(keyframeFlowThresh)));
+        }
+        else if (keyframePolicy == "time")
+        {
+            tracker->SetKeyframePolicy(unique_ptr<feature::KeyframePolicy>(new feature::TimeKeyframePolicy(keyframeTimeThresh)));
+        }
+        else if (keyframePolicy != "interval")
+        {
+            ROS_ERROR("Invalid keyframe policy specified");
+        }
+    }
+
     unique_ptr<odometry::FivePoint> checker(new odometry::FivePoint(fivePointRansacIterations, fivePointThreshold, 0, false, 0));
 
-    trackingModule_.reset(new module::TrackingModule(detector, tracker, checker, minFeaturesRegion, maxFeaturesRegion));
+    trackingModule_.reset(new module::TrackingModule(detector, tracker, checker, minFeaturesRegion, maxFeaturesRegion, redetectSuppressionRadius, redetectAdaptiveThresholds));
 }
 
 template <bool Stereo>
@@ -121,6 +179,24 @@ void TrackingEval<Stereo>::GetResultsData(std::map<std::string, std::vector<std:
         data["track_counts"].emplace_back(begin(v), end(v));
     }
     data["track_lengths"] = {vector<double>(stats.trackLengths.begin(), stats.trackLengths.end())};
+    data["keyframes"] = {vector<double>(stats.keyframes.begin(), stats.keyframes.end())};
+    data["track_times"] = stats.frameTrackTimes;
+    if (!stats.kernelBenchmarks.empty())
+    {
+        data["lk_kernel_benchmarks"] = stats.kernelBenchmarks;
+    }
+    data["rejected_counts"] = vector<vector<double>>();
+    data["rejected_counts"].reserve(stats.frameRejectedCounts.size());
+    for (auto &&v : stats.frameRejectedCounts)
+    {
+        data["rejected_counts"].emplace_back(begin(v), end(v));
+    }
+    data["landmark_counts"] = vector<vector<double>>();
+    data["landmark_counts"].reserve(stats.frameLandmarkCounts.size());
+    for (auto &&v : stats.frameLandmarkCounts)
+    {
+        data["landmark_counts"].emplace_back(begin(v), end(v));
+    }
 }
 
 template <bool Stereo>
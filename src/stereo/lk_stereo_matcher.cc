@@ -16,7 +16,7 @@ LKStereoMatcher::LKStereoMatcher(double epipolar_thresh, int window_size, int nu
 {
 }
 
-void LKStereoMatcher::FindMatches(const cv::Mat &image1, const cv::Mat &image2, const std::vector<cv::KeyPoint> &pts1, std::vector<cv::KeyPoint> &pts2, std::vector<int> &matchedIndices) const
+void LKStereoMatcher::FindMatches(data::Frame &frame, const std::vector<cv::KeyPoint> &pts1, std::vector<cv::KeyPoint> &pts2, std::vector<int> &matchedIndices) const
 {
     std::vector<cv::Point2f> pointsToTrack;
     pointsToTrack.reserve(pts1.size());
@@ -27,7 +27,7 @@ void LKStereoMatcher::FindMatches(const cv::Mat &image1, const cv::Mat &image2,
     std::vector<cv::Point2f> results;
     std::vector<unsigned char> status;
     std::vector<float> err;
-    cv::calcOpticalFlowPyrLK(image1, image2, pointsToTrack, results, status, err, windowSize_, numScales_, termCrit_, 0);
+    cv::calcOpticalFlowPyrLK(frame.GetPyramid(windowSize_, numScales_), frame.GetStereoPyramid(windowSize_, numScales_), pointsToTrack, results, status, err, windowSize_, numScales_, termCrit_, 0);
     pts2.clear();
     matchedIndices.clear();
     for (int i = 0; i < results.size(); i++)
@@ -14,7 +14,7 @@ public:
     LKStereoMatcher(double epipolar_thresh, int window_size, int num_scales, float err_thresh = 20., int term_count = 50, double term_eps = 0.01);
 
 private:
-    void FindMatches(const cv::Mat &image1, const cv::Mat &image2, const std::vector<cv::KeyPoint> &pts1, std::vector<cv::KeyPoint> &pts2, std::vector<int> &matchedIndices) const;
+    void FindMatches(data::Frame &frame, const std::vector<cv::KeyPoint> &pts1, std::vector<cv::KeyPoint> &pts2, std::vector<int> &matchedIndices) const;
 
     cv::TermCriteria termCrit_;
     const cv::Size windowSize_;
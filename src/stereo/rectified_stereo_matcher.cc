@@ -0,0 +1,182 @@
+#include "rectified_stereo_matcher.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace omni_slam
+{
+namespace stereo
+{
+
+RectifiedStereoMatcher::RectifiedStereoMatcher(double epipolar_thresh, int patch_size, int max_disparity, float err_thresh, int term_count, double term_eps)
+    : StereoMatcher(epipolar_thresh),
+    patchSize_(patch_size / 2 * 2 + 1),
+    maxDisparity_(max_disparity),
+    errThresh_(err_thresh),
+    termCrit_(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, term_count, term_eps)
+{
+}
+
+void RectifiedStereoMatcher::FindMatches(data::Frame &frame, const std::vector<cv::KeyPoint> &pts1, std::vector<cv::KeyPoint> &pts2, std::vector<int> &matchedIndices) const
+{
+    UpdateRectification(frame);
+
+    cv::Mat rectImg1;
+    cv::Mat rectImg2;
+    remap_->Remap(frame.GetImage(), rectImg1);
+    stereoRemap_->Remap(frame.GetStereoImage(), rectImg2);
+    if (rectImg1.channels() > 1)
+    {
+        cv::cvtColor(rectImg1, rectImg1, cv::COLOR_BGR2GRAY);
+        cv::cvtColor(rectImg2, rectImg2, cv::COLOR_BGR2GRAY);
+    }
+    rectImg1.convertTo(rectImg1, CV_32F);
+    rectImg2.convertTo(rectImg2, CV_32F);
+
+    pts2.assign(pts1.begin(), pts1.end());
+    matchedIndices.clear();
+    std::vector<unsigned char> status(pts1.size(), 0);
+    #pragma omp parallel for
+    for (int i = 0; i < pts1.size(); i++)
+    {
+        cv::Point2f rectPt1;
+        if (!remap_->ImageToRemap(pts1[i].pt, rectPt1))
+        {
+            continue;
+        }
+        Vector3d bearing1;
+        if (!frame.GetCameraModel().UnprojectToBearing(Vector2d(pts1[i].pt.x, pts1[i].pt.y), bearing1))
+        {
+            continue;
+        }
+        // The point at infinity fixes the epipolar row and bounds the disparity range, it may itself fall outside the remap
+        cv::Point2f infPt2;
+        stereoRemap_->BearingToRemap(stereoRotation_ * bearing1, infPt2);
+        cv::Point2f rectPt2;
+        float err;
+        if (!Search(rectImg1, rectImg2, rectPt1, infPt2, rectPt2, err))
+        {
+            continue;
+        }
+        cv::Point2f pt2;
+        if (!stereoRemap_->RemapToImage(rectPt2, pt2))
+        {
+            continue;
+        }
+        pts2[i] = cv::KeyPoint(pt2, pts1[i].size);
+        status[i] = 1;
+    }
+    for (int i = 0; i < status.size(); i++)
+    {
+        if (status[i] == 1)
+        {
+            matchedIndices.push_back(i);
+        }
+    }
+}
+
+void RectifiedStereoMatcher::UpdateRectification(data::Frame &frame) const
+{
+    const Matrix<double, 3, 4> &stereoPose = frame.GetStereoPose();
+    const cv::Size imageSize = frame.GetImage().size();
+    if (remap_ && stereoRemap_ && rectImageSize_ == imageSize && rectStereoPose_.isApprox(stereoPose))
+    {
+        return;
+    }
+    // Rectified x axis along the baseline so every epipolar plane maps to one remap row, z kept closest to the optical axis
+    const Matrix3d R = stereoPose.block<3, 3>(0, 0);
+    const Vector3d x = (-R.transpose() * stereoPose.block<3, 1>(0, 3)).normalized();
+    Vector3d z = Vector3d::UnitZ() - x * x(2);
+    if (z.norm() < 1e-6)
+    {
+        z = Vector3d::UnitY() - x * x(1);
+    }
+    z.normalize();
+    Matrix3d rect;
+    rect.row(0) = x.transpose();
+    rect.row(1) = z.cross(x).transpose();
+    rect.row(2) = z.transpose();
+
+    // Both remaps share one angular grid and extent, otherwise rows drift apart when the intrinsics differ
+    const cv::Size stereoImageSize = frame.GetStereoImage().size();
+    double resolution = 0;
+    for (double res : {frame.GetCameraModel().GetAngularResolution(Vector2d(imageSize.width / 2., imageSize.height / 2.)), frame.GetStereoCameraModel().GetAngularResolution(Vector2d(stereoImageSize.width / 2., stereoImageSize.height / 2.))})
+    {
+        if (res > 0 && (resolution <= 0 || res < resolution))
+        {
+            resolution = res;
+        }
+    }
+    const double fov = std::max(frame.GetCameraModel().GetFOV(), frame.GetStereoCameraModel().GetFOV());
+    if (resolution <= 0)
+    {
+        resolution = fov / std::max({imageSize.width, stereoImageSize.width, 1});
+    }
+    remap_.reset(new camera::SphericalRemap(frame.GetCameraModel(), imageSize, rect, fov, resolution));
+    stereoRemap_.reset(new camera::SphericalRemap(frame.GetStereoCameraModel(), stereoImageSize, rect * R.transpose(), fov, resolution));
+    stereoRotation_ = R;
+    rectStereoPose_ = stereoPose;
+    rectImageSize_ = imageSize;
+}
+
+bool RectifiedStereoMatcher::Search(const cv::Mat &img1, const cv::Mat &img2, const cv::Point2f &pt1, const cv::Point2f &inf_pt2, cv::Point2f &pt2, float &err) const
+{
+    const int half = patchSize_ / 2;
+    const int x1 = cvRound(pt1.x);
+    const int y1 = cvRound(pt1.y);
+    const int y2 = cvRound(inf_pt2.y);
+    if (x1 - half < 0 || y1 - half < 0 || x1 + half >= img1.cols || y1 + half >= img1.rows)
+    {
+        return false;
+    }
+    if (y2 - half < 0 || y2 + half >= img2.rows)
+    {
+        return false;
+    }
+    // Finite depth only moves the second view away from infinity toward lower polar angle
+    const int xMax = std::min(cvRound(inf_pt2.x), img2.cols - 1 - half);
+    const int xMin = std::max(cvRound(inf_pt2.x) - maxDisparity_, half);
+    if (xMax < xMin)
+    {
+        return false;
+    }
+    cv::Mat cost;
+    cv::matchTemplate(img2(cv::Rect(xMin - half, y2 - half, xMax - xMin + patchSize_, patchSize_)), img1(cv::Rect(x1 - half, y1 - half, patchSize_, patchSize_)), cost, cv::TM_SQDIFF);
+    cv::Point minLoc;
+    cv::minMaxLoc(cost, nullptr, nullptr, &minLoc);
+
+    // 1D Lucas-Kanade along the row from the best integer disparity
+    cv::Mat tmpl;
+    cv::getRectSubPix(img1, cv::Size(patchSize_, patchSize_), pt1, tmpl);
+    float x = xMin + minLoc.x + (pt1.x - x1);
+    cv::Mat warped;
+    cv::Mat diff;
+    for (int iter = 0; iter < termCrit_.maxCount; iter++)
+    {
+        cv::getRectSubPix(img2, cv::Size(patchSize_ + 2, patchSize_), cv::Point2f(x, inf_pt2.y), warped);
+        cv::Mat grad = (warped.colRange(2, warped.cols) - warped.colRange(0, warped.cols - 2)) * 0.5;
+        diff = tmpl - warped.colRange(1, warped.cols - 1);
+        double gradSq = grad.dot(grad);
+        if (gradSq < 1e-6)
+        {
+            break;
+        }
+        double dx = grad.dot(diff) / gradSq;
+        x += dx;
+        if (std::abs(dx) < termCrit_.epsilon)
+        {
+            break;
+        }
+    }
+    if (x < xMin - 1 || x > xMax + 1)
+    {
+        return false;
+    }
+    cv::getRectSubPix(img2, cv::Size(patchSize_, patchSize_), cv::Point2f(x, inf_pt2.y), warped);
+    err = cv::norm(tmpl, warped, cv::NORM_L1) / (patchSize_ * patchSize_);
+    pt2 = cv::Point2f(x, inf_pt2.y);
+    return err <= errThresh_;
+}
+
+}
+}
@@ -0,0 +1,39 @@
+#ifndef _RECTIFIED_STEREO_MATCHER_H_
+#define _RECTIFIED_STEREO_MATCHER_H_
+
+#include "stereo_matcher.h"
+#include "camera/spherical_remap.h"
+
+#include <memory>
+
+namespace omni_slam
+{
+namespace stereo
+{
+
+class RectifiedStereoMatcher : public StereoMatcher
+{
+public:
+    RectifiedStereoMatcher(double epipolar_thresh, int patch_size = 11, int max_disparity = 64, float err_thresh = 20., int term_count = 10, double term_eps = 0.01);
+
+private:
+    void FindMatches(data::Frame &frame, const std::vector<cv::KeyPoint> &pts1, std::vector<cv::KeyPoint> &pts2, std::vector<int> &matchedIndices) const;
+    void UpdateRectification(data::Frame &frame) const;
+    bool Search(const cv::Mat &img1, const cv::Mat &img2, const cv::Point2f &pt1, const cv::Point2f &inf_pt2, cv::Point2f &pt2, float &err) const;
+
+    const int patchSize_;
+    const int maxDisparity_;
+    const float errThresh_;
+    cv::TermCriteria termCrit_;
+
+    mutable std::unique_ptr<camera::SphericalRemap> remap_;
+    mutable std::unique_ptr<camera::SphericalRemap> stereoRemap_;
+    mutable Matrix<double, 3, 4> rectStereoPose_;
+    mutable Matrix3d stereoRotation_;
+    mutable cv::Size rectImageSize_;
+};
+
+}
+}
+
+#endif /* _RECTIFIED_STEREO_MATCHER_H_ */
@@ -58,7 +58,7 @@ int StereoMatcher::Match(data::Frame &frame, std::vector<data::Landmark> &landma
 
     std::vector<cv::KeyPoint> matchedPoints;
     std::vector<int> matchedIndices;
-    FindMatches(frame.GetImage(), frame.GetStereoImage(), pointsToMatch, matchedPoints, matchedIndices);
+    FindMatches(frame, pointsToMatch, matchedPoints, matchedIndices);
 
     Matrix<double, 3, 4> I = util::TFUtil::IdentityPoseMatrix<double>();
     Matrix3d E = util::TFUtil::GetEssentialMatrixFromPoses(I, frame.GetStereoPose());